@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "mapped_file.h"
+
+// Packed archive of asset files, read through a single mapping. The file
+// is an AssetArchiveHeader, a table of AssetArchiveEntry sorted by name
+// hash, a string table with the entry names and the entry data in the
+// order the entries were packed, so loading a level's assets reads the
+// file front to back. Entry data starts on ASSET_ARCHIVE_ALIGNMENT
+// boundaries and stored entries are used in place, e.g. a mesh cache
+// entry still hands its blobs to glBufferData straight from the mapping.
+// Names are relative paths with '/' separators.
+constexpr std::uint32_t ASSET_ARCHIVE_VERSION = 1;
+constexpr std::uint64_t ASSET_ARCHIVE_ALIGNMENT = 64;
+
+enum class AssetCompression : std::uint32_t {
+	None = 0,
+	// LZ4 block, see lz4_block.h
+	LZ4 = 1,
+};
+
+struct AssetArchiveHeader {
+	char magic[8];
+	std::uint32_t version;
+	std::uint32_t entry_count;
+	std::uint64_t string_table_offset;
+	std::uint64_t string_table_size;
+	std::uint64_t file_size;
+};
+
+struct AssetArchiveEntry {
+	// hash_bytes of the name
+	std::uint64_t name_hash;
+	std::uint64_t offset;
+	// bytes in the archive
+	std::uint64_t size;
+	// bytes once decompressed, size when stored as is
+	std::uint64_t decompressed_size;
+	std::uint32_t name_offset;
+	std::uint32_t name_length;
+	AssetCompression compression;
+	std::uint32_t reserved;
+};
+
+class AssetArchive {
+public:
+	// maps the archive, false after printing why when it is missing or malformed
+	bool open(const std::string &path);
+
+	// entry called name, null when there is none
+	[[nodiscard]] const AssetArchiveEntry* find(std::string_view name) const;
+	[[nodiscard]] std::string_view get_name(const AssetArchiveEntry &entry) const;
+	// the bytes as stored, compressed or not
+	[[nodiscard]] const unsigned char* get_data(const AssetArchiveEntry &entry) const;
+	// starts reading the entry in
+	void prefetch(const AssetArchiveEntry &entry) const;
+
+	[[nodiscard]] std::span<const AssetArchiveEntry> get_entries() const;
+	[[nodiscard]] const std::string& get_path() const;
+
+private:
+	std::string path;
+	MappedFile file;
+	std::span<const AssetArchiveEntry> entries;
+	std::string_view strings;
+};
+
+struct AssetArchiveSource {
+	// name inside the archive
+	std::string name;
+	// file to pack
+	std::string path;
+};
+
+struct AssetArchiveStats {
+	size_t entry_count;
+	size_t compressed_count;
+	size_t source_size;
+	size_t archive_size;
+};
+
+// Packs sources, in their order, into an archive at path. With compress
+// entries are stored as LZ4 when that makes them at least a quarter
+// smaller, the others stay in place for mapping. False after printing why.
+bool write_asset_archive(const std::string &path, const std::vector<AssetArchiveSource> &sources, bool compress,
+	AssetArchiveStats &stats);
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+
+#include "mip_generator.h"
+#include "mpsc_queue.h"
+#include "texture_container.h"
+#include "thread_pool.h"
+
+// Decodes image files and builds their mip chains on the thread pool, the GL
+// thread only uploads the finished levels. A KTX2/DDS file next to the image
+// is read instead of decoding it, see find_compressed_texture.
+// load() returns a texture name right away which holds a 1x1 placeholder
+// until upload_pending() replaces it with the decoded image. Everything but
+// the decode itself must be called on the thread owning the GL context.
+class AsyncTextureLoader {
+public:
+	explicit AsyncTextureLoader(ThreadPool &pool = ThreadPool::shared());
+	// waits for decodes still running on the pool
+	~AsyncTextureLoader();
+
+	AsyncTextureLoader(const AsyncTextureLoader&) = delete;
+	AsyncTextureLoader& operator=(const AsyncTextureLoader&) = delete;
+
+	// creates the texture and queues the decode of image_path, srgb selects
+	// an sRGB internal format for colour textures and a non zero channels
+	// converts the decoded image to that many channels
+	unsigned int load(const std::string &image_path, bool srgb = false, int channels = 0);
+	// queues the decode of image_path into an existing texture name, its
+	// storage gets respecified so it must not come from create_texture_2d
+	void load_into(unsigned int texture_id, const std::string &image_path, bool srgb = false, int channels = 0);
+	// uploads decoded images until budget_ms is spent, at least one per call
+	// so loading always progresses, returns the number of uploads
+	unsigned int upload_pending(double budget_ms);
+	// drops the pending upload into texture_id if there is one, call before
+	// deleting a texture that may still be loading
+	void cancel(unsigned int texture_id);
+
+	// true once every requested texture has been uploaded or cancelled
+	[[nodiscard]] bool is_idle() const;
+	[[nodiscard]] unsigned int get_pending_count() const;
+
+private:
+	struct DecodedImage {
+		unsigned int texture_id;
+		// the load_into call this image belongs to
+		std::uint64_t ticket;
+		bool srgb;
+		// requested channel count, 0 for the file's
+		int channels;
+		// levels when a compressed file was read, mips stays empty then
+		CompressedImage compressed;
+		// no levels when the decode failed
+		MipChain mips;
+		std::string path;
+	};
+
+	void upload(const DecodedImage &image);
+	void upload(unsigned int texture_id, const MipChain &mips);
+	void upload(unsigned int texture_id, const CompressedImage &image, bool srgb);
+
+	ThreadPool &pool;
+	MpscQueue<DecodedImage> decoded;
+	// images taken off the queue that did not fit in the last budget
+	std::deque<DecodedImage> ready;
+	// ticket of the load each texture is waiting for. A decode whose ticket
+	// is not in here was cancelled or superseded, by a later load_into or by
+	// a deleted texture name being handed out again, and is dropped.
+	std::unordered_map<unsigned int, std::uint64_t> awaited_tickets;
+	std::uint64_t next_ticket;
+	std::atomic<unsigned int> in_flight;
+	unsigned int pending;
+};
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// 64 bit FNV-1a of a byte range, pass a previous result as seed to hash piecewise
+std::uint64_t hash_bytes(const void* data, size_t size, std::uint64_t seed = 0xcbf29ce484222325ull);
+
+// hash of a file's contents, false if the file could not be read
+bool hash_file(const std::string& path, std::uint64_t& hash);
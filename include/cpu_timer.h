@@ -0,0 +1,22 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+
+// Accumulates the CPU time spent between begin() and end() and prints the
+// average per sample to stdout every report_interval samples.
+class CpuTimer {
+public:
+	explicit CpuTimer(std::string label, unsigned int report_interval = 500);
+	void begin();
+	void end();
+	void reset();
+	[[nodiscard]] double get_average_us() const;
+
+private:
+	std::string label;
+	std::chrono::steady_clock::time_point start;
+	std::chrono::steady_clock::duration total;
+	unsigned int samples;
+	unsigned int report_interval;
+};
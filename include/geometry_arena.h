@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+
+#include <glad/glad.h>
+
+#include "vertex_packing.h"
+
+// Vertex and index storage shared by many meshes of one vertex layout: one
+// vertex buffer, one index buffer and one vertex array. Meshes get a base
+// vertex and an index byte offset and draw with glDrawElementsBaseVertex,
+// so switching between them needs no VAO or buffer binds. Allocations are
+// never freed, the buffers grow by copying into larger ones.
+class GeometryArena {
+public:
+	// instanced uint attribute holding baseInstance + gl_InstanceID, lets
+	// multi draw indirect shaders find their draw without gl_DrawID
+	static constexpr unsigned int DRAW_ID_ATTRIBUTE = 7;
+
+	// capacities are the initial buffer sizes in bytes
+	explicit GeometryArena(const VertexBufferLayout &layout,
+	                       size_t vertex_capacity = 4 << 20, size_t index_capacity = 2 << 20);
+	~GeometryArena();
+
+	GeometryArena(const GeometryArena&) = delete;
+	GeometryArena& operator=(const GeometryArena&) = delete;
+
+	// copies count vertices of the layout's stride, returns their base vertex
+	unsigned int add_vertices(const void *data, size_t count);
+	// copies size bytes of indices, returns their byte offset in the index buffer
+	size_t add_indices(const void *data, size_t size);
+	// makes DRAW_ID_ATTRIBUTE valid for draw ids up to count - 1
+	void reserve_draw_ids(size_t count);
+
+	void bind() const;
+	[[nodiscard]] unsigned int get_vertex_array() const;
+	[[nodiscard]] size_t get_vertex_count() const;
+	[[nodiscard]] size_t get_index_bytes() const;
+
+	// arena shared by every mesh uploaded in the given layout, created on
+	// first use and kept for the lifetime of the context
+	static GeometryArena& shared(VertexFormat format, bool skinned);
+
+private:
+	// replaces buffer by one of at least required bytes holding the first used bytes
+	static void grow(unsigned int &buffer, size_t used, size_t &capacity, size_t required);
+	void setup_vertex_array();
+
+	unsigned int vertex_array;
+	unsigned int vertex_buffer;
+	unsigned int index_buffer;
+	unsigned int draw_id_buffer;
+	size_t draw_id_count;
+	VertexBufferLayout layout;
+	unsigned int vertex_stride;
+	size_t vertex_count;
+	size_t vertex_capacity;
+	size_t index_bytes;
+	size_t index_capacity;
+};
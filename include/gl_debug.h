@@ -0,0 +1,70 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// Location of the GL call currently being issued on this thread. GL_CALL
+// records it around every call so the KHR_debug callback, which runs in
+// synchronous mode on the calling thread, can attribute messages to the
+// source line that triggered them. It is restored once the call returns,
+// so messages raised by unwrapped calls are not pinned on a stale line.
+struct GlCallSite {
+	const char *call;
+	const char *file;
+	unsigned int line;
+};
+
+extern thread_local GlCallSite gl_call_site;
+
+inline void gl_set_call_site(const char *call, const char *file, unsigned int line)
+{
+	gl_call_site = {call, file, line};
+}
+
+// Tags the GL calls in the rest of the enclosing scope, GL_CALL uses one per
+// call and GL_CALL_SITE_SCOPE one for code that does not use GL_CALL.
+class GlCallSiteScope {
+public:
+	GlCallSiteScope(const char *call, const char *file, unsigned int line): previous(gl_call_site)
+	{
+		gl_set_call_site(call, file, line);
+	}
+
+	~GlCallSiteScope()
+	{
+		gl_call_site = previous;
+	}
+
+	GlCallSiteScope(const GlCallSiteScope&) = delete;
+	GlCallSiteScope& operator=(const GlCallSiteScope&) = delete;
+
+private:
+	GlCallSite previous;
+};
+
+#define GL_DEBUG_CONCAT_IMPL(a, b) a##b
+#define GL_DEBUG_CONCAT(a, b) GL_DEBUG_CONCAT_IMPL(a, b)
+#define GL_CALL_SITE_SCOPE(name) GlCallSiteScope GL_DEBUG_CONCAT(gl_call_site_scope_, __LINE__)(name, __FILE__, __LINE__)
+
+void APIENTRY gl_debug_message_callback(GLenum source,
+                                        GLenum type,
+                                        GLuint id,
+                                        GLenum severity,
+                                        GLsizei length,
+                                        const GLchar *message,
+                                        const void *user_param);
+
+// Registers gl_debug_message_callback and enables debug output. Synchronous
+// mode is needed for call site attribution, it may slow down the driver.
+void gl_enable_debug_output(bool synchronous = true);
+
+// Toggles debug output at runtime, the callback and filters stay in place.
+void gl_set_debug_output(bool enabled);
+
+// Messages below min_severity (GL_DEBUG_SEVERITY_NOTIFICATION, _LOW, _MEDIUM
+// or _HIGH) are dropped by the driver before reaching the callback.
+void gl_set_debug_min_severity(GLenum min_severity);
+
+// Drops the message with this id from source and type (GL_DEBUG_SOURCE_*,
+// GL_DEBUG_TYPE_*), e.g. vendor specific buffer usage hints. Filtered by
+// the driver, the callback never sees it.
+void gl_ignore_debug_message(GLenum source, GLenum type, GLuint id);
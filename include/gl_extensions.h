@@ -0,0 +1,68 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// Entry points newer than the GL 4.3 core profile glad was generated for.
+// They are resolved with glfwGetProcAddress the first time gl_extensions()
+// is called and stay null when the driver does not expose them, so check
+// the matching flag before calling one.
+
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#define GL_CLIENT_STORAGE_BIT 0x0200
+#endif
+
+// EXT_texture_compression_s3tc and the sRGB variants from EXT_texture_sRGB,
+// not part of core so glad does not define them
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT 0x8C4D
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
+struct GLExtensions {
+	// EXT_texture_compression_s3tc, BC1 to BC3; BC4 to BC7 are core since 4.2
+	bool texture_compression_s3tc = false;
+
+	// GL 4.1 or ARB_get_program_binary; glad only loads its core entry points on 4.1 contexts
+	bool get_program_binary = false;
+	void (APIENTRYP GetProgramBinary)(GLuint program, GLsizei size, GLsizei *length, GLenum *format, void *binary) = nullptr;
+	void (APIENTRYP ProgramBinary)(GLuint program, GLenum format, const void *binary, GLsizei length) = nullptr;
+	void (APIENTRYP ProgramParameteri)(GLuint program, GLenum name, GLint value) = nullptr;
+
+	// GL 4.4 or ARB_buffer_storage
+	bool buffer_storage = false;
+	void (APIENTRYP BufferStorage)(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags) = nullptr;
+
+	// GL 4.5 or ARB_direct_state_access, only the functions used here
+	bool direct_state_access = false;
+	void (APIENTRYP CreateBuffers)(GLsizei n, GLuint *buffers) = nullptr;
+	void (APIENTRYP NamedBufferStorage)(GLuint buffer, GLsizeiptr size, const void *data, GLbitfield flags) = nullptr;
+	void (APIENTRYP NamedBufferSubData)(GLuint buffer, GLintptr offset, GLsizeiptr size, const void *data) = nullptr;
+	void (APIENTRYP CreateTextures)(GLenum target, GLsizei n, GLuint *textures) = nullptr;
+	void (APIENTRYP TextureStorage2D)(GLuint texture, GLsizei levels, GLenum internal_format, GLsizei width, GLsizei height) = nullptr;
+	void (APIENTRYP TextureSubImage2D)(GLuint texture, GLint level, GLint x, GLint y, GLsizei width, GLsizei height,
+		GLenum format, GLenum type, const void *pixels) = nullptr;
+	void (APIENTRYP CompressedTextureSubImage2D)(GLuint texture, GLint level, GLint x, GLint y, GLsizei width, GLsizei height,
+		GLenum format, GLsizei size, const void *data) = nullptr;
+	void (APIENTRYP TextureParameteri)(GLuint texture, GLenum name, GLint param) = nullptr;
+	void (APIENTRYP GenerateTextureMipmap)(GLuint texture) = nullptr;
+	void (APIENTRYP BindTextureUnit)(GLuint unit, GLuint texture) = nullptr;
+	void (APIENTRYP CreateVertexArrays)(GLsizei n, GLuint *arrays) = nullptr;
+	void (APIENTRYP EnableVertexArrayAttrib)(GLuint vertex_array, GLuint index) = nullptr;
+	void (APIENTRYP VertexArrayVertexBuffer)(GLuint vertex_array, GLuint binding, GLuint buffer, GLintptr offset, GLsizei stride) = nullptr;
+	void (APIENTRYP VertexArrayElementBuffer)(GLuint vertex_array, GLuint buffer) = nullptr;
+	void (APIENTRYP VertexArrayAttribFormat)(GLuint vertex_array, GLuint index, GLint size, GLenum type,
+		GLboolean normalized, GLuint relative_offset) = nullptr;
+	void (APIENTRYP VertexArrayAttribIFormat)(GLuint vertex_array, GLuint index, GLint size, GLenum type, GLuint relative_offset) = nullptr;
+	void (APIENTRYP VertexArrayAttribBinding)(GLuint vertex_array, GLuint index, GLuint binding) = nullptr;
+	void (APIENTRYP VertexArrayBindingDivisor)(GLuint vertex_array, GLuint binding, GLuint divisor) = nullptr;
+};
+
+// needs a current context, the first call loads the entry points
+const GLExtensions& gl_extensions();
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include <glad/glad.h>
+
+// Shadows the GL binding state of the context current on this thread and
+// drops bind calls that would not change it. All binds of programs, vertex
+// arrays, buffers and textures done through the wrapper classes go through
+// here; code issuing raw glBind* calls has to call invalidate() afterwards.
+class GLStateCache {
+public:
+	struct Counters {
+		std::uint64_t issued;
+		std::uint64_t skipped;
+	};
+
+	static GLStateCache& get();
+
+	void use_program(unsigned int program);
+	void bind_vertex_array(unsigned int vertex_array);
+	void bind_buffer(GLenum target, unsigned int buffer);
+	// unit is the zero based texture unit index, not GL_TEXTUREi
+	void active_texture(unsigned int unit);
+	void bind_texture(GLenum target, unsigned int texture);
+	void bind_texture(unsigned int unit, GLenum target, unsigned int texture);
+
+	// GL unbinds deleted objects, keep the shadow state in sync
+	void on_program_deleted(unsigned int program);
+	void on_vertex_array_deleted(unsigned int vertex_array);
+	void on_buffer_deleted(unsigned int buffer);
+	void on_texture_deleted(unsigned int texture);
+
+	// forget everything, the next bind of each kind always reaches the driver
+	void invalidate();
+
+	[[nodiscard]] const Counters& get_counters() const;
+	void reset_counters();
+
+private:
+	GLStateCache();
+
+	bool changed(unsigned int& cached, unsigned int value);
+
+	static constexpr unsigned int UNKNOWN = ~0u;
+	static constexpr unsigned int MAX_TEXTURE_UNITS = 32;
+	static constexpr std::array<GLenum, 7> buffer_targets = {
+		GL_ARRAY_BUFFER,
+		GL_ELEMENT_ARRAY_BUFFER,
+		GL_UNIFORM_BUFFER,
+		GL_SHADER_STORAGE_BUFFER,
+		GL_DRAW_INDIRECT_BUFFER,
+		GL_COPY_READ_BUFFER,
+		GL_COPY_WRITE_BUFFER,
+	};
+	static constexpr std::array<GLenum, 3> texture_targets = {
+		GL_TEXTURE_2D,
+		GL_TEXTURE_2D_ARRAY,
+		GL_TEXTURE_CUBE_MAP,
+	};
+
+	unsigned int program;
+	unsigned int vertex_array;
+	std::array<unsigned int, buffer_targets.size()> buffers;
+	unsigned int active_unit;
+	std::array<std::array<unsigned int, texture_targets.size()>, MAX_TEXTURE_UNITS> textures;
+	Counters counters;
+};
@@ -1,12 +1,48 @@
 #pragma once
 
+#include <cstddef>
+#include <span>
+#include <vector>
+
+// Part of an index buffer drawn with its own base vertex, lets meshes with
+// more than 65536 vertices still use 16 bit indices.
+struct IndexRange {
+	unsigned int first_index;
+	unsigned int count;
+	unsigned int base_vertex;
+};
+
+// Indices in the narrowest type that can address the mesh.
+struct PackedIndices {
+	// empty when the indices stay 32 bit, they are used as passed in then
+	std::vector<unsigned char> data;
+	// GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+	unsigned int type;
+	unsigned int index_size;
+	std::vector<IndexRange> ranges;
+};
+
+// at most this many ranges are made before falling back to 32 bit indices
+constexpr size_t MAX_INDEX_RANGES = 16;
+
+// 16 bit indices whenever the mesh has at most 65536 vertices. Larger meshes
+// are cut into ranges at triangle boundaries when split_ranges is set, which
+// works best on vertices in first use order (optimize_vertex_fetch).
+PackedIndices pack_indices(std::span<const unsigned int> indices, bool split_ranges);
+
 class IndexBuffer {
 public:
-	IndexBuffer(const void *data, size_t size);
+	// count 32 bit indices
+	IndexBuffer(const void *data, size_t count);
 	~IndexBuffer();
 	void bind() const;
 	void unbind() const;
+	[[nodiscard]] unsigned int get_count() const;
+	[[nodiscard]] unsigned int get_renderer_id() const;
 
 private:
+	void create(const void *data, size_t size);
+
 	unsigned int renderer_id;
+	unsigned int count;
 };
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "model.h"
+
+// Draws all meshes of a Model for many instances with one
+// glMultiDrawElementsIndirect per vertex array and index type, instead of a
+// draw, uniform updates and texture binds per mesh. The meshes have to be
+// in a compact vertex format in shared geometry. Per draw data goes to an
+// SSBO, instance transforms to another and the first diffuse and specular
+// texture of every mesh are copied into one texture array each, so nothing
+// changes between draws. Pairs with indirect.vert/indirect.frag of the
+// 3.model_loading/2.indirect_draw demo.
+class IndirectModelDraw {
+public:
+	static constexpr unsigned int DRAW_DATA_BINDING = 0;
+	static constexpr unsigned int INSTANCE_BINDING = 1;
+	static constexpr unsigned int DIFFUSE_UNIT = 0;
+	static constexpr unsigned int SPECULAR_UNIT = 1;
+	// material textures are scaled to a common size of at most this
+	static constexpr int MAX_LAYER_SIZE = 2048;
+
+	// the model's textures have to be uploaded, they are copied once here
+	explicit IndirectModelDraw(const Model &model);
+	~IndirectModelDraw();
+
+	IndirectModelDraw(const IndirectModelDraw&) = delete;
+	IndirectModelDraw& operator=(const IndirectModelDraw&) = delete;
+
+	// every mesh is drawn once per transform
+	void set_instances(const std::vector<glm::mat4> &transforms);
+	// shader has to be in use
+	void draw(const Shader &shader) const;
+
+	[[nodiscard]] bool is_valid() const;
+	[[nodiscard]] unsigned int get_command_count() const;
+
+private:
+	// layout fixed by GL
+	struct DrawElementsIndirectCommand {
+		GLuint count;
+		GLuint instance_count;
+		GLuint first_index;
+		GLint base_vertex;
+		GLuint base_instance;
+	};
+
+	// std430 mirror of DrawData in indirect.vert
+	struct DrawData {
+		glm::vec4 position_offset;
+		glm::vec4 position_scale;
+		GLuint diffuse_layer;
+		GLuint specular_layer;
+		GLuint padding[2];
+	};
+
+	// commands drawn by one glMultiDrawElementsIndirect
+	struct Batch {
+		GeometryArena *arena;
+		GLenum index_type;
+		size_t first_command;
+		GLsizei command_count;
+	};
+
+	// copies textures into layers 1.. of a new array, layer 0 is white for meshes without one;
+	// block compressed textures of one format and size stay compressed, see indirect_draw.cpp
+	static unsigned int build_texture_array(const std::vector<unsigned int> &textures);
+
+	std::vector<DrawElementsIndirectCommand> commands;
+	std::vector<Batch> batches;
+	unsigned int command_buffer;
+	unsigned int draw_data_buffer;
+	unsigned int instance_buffer;
+	unsigned int diffuse_array;
+	unsigned int specular_array;
+	unsigned int instance_count;
+	bool valid;
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+class StreamBuffer;
+
+// Per instance data streamed into a vertex buffer that is read with an
+// attribute divisor of 1. Every instance has a model matrix, declared in
+// GLSL as `layout (location = 8) in mat4` (it fills attributes 8 to 11), and
+// a free vec4 at location 12, e.g. a colour. The locations stay clear of the
+// mesh attributes (0 to 6) and the arena draw id (7).
+class InstanceBuffer {
+public:
+	static constexpr unsigned int MODEL_ATTRIBUTE = 8;
+	static constexpr unsigned int DATA_ATTRIBUTE = 12;
+
+	// capacity in instances, the buffer grows when more are set
+	explicit InstanceBuffer(size_t capacity = 256);
+	~InstanceBuffer();
+
+	InstanceBuffer(const InstanceBuffer&) = delete;
+	InstanceBuffer& operator=(const InstanceBuffer&) = delete;
+
+	// replaces the instances, data is either empty (all zero) or one per transform
+	void set_instances(std::span<const glm::mat4> transforms, std::span<const glm::vec4> data = {});
+	// same, but writes them into the current frame region of stream instead
+	// of this buffer, for instances that change every frame
+	void set_instances(StreamBuffer &stream, std::span<const glm::mat4> transforms, std::span<const glm::vec4> data = {});
+
+	// binds vertex_array and points its instance attributes at this buffer.
+	// Vertex arrays may be shared between instance buffers, so the draw
+	// functions below attach on every call.
+	void attach(unsigned int vertex_array) const;
+	void draw_arrays(unsigned int vertex_array, GLenum mode, GLint first, GLsizei vertex_count) const;
+	void draw_elements(unsigned int vertex_array, GLenum mode, GLsizei index_count, GLenum type, const void *offset, GLint base_vertex = 0) const;
+
+	[[nodiscard]] size_t get_count() const;
+
+private:
+	struct Instance {
+		glm::mat4 model;
+		glm::vec4 data;
+	};
+
+	unsigned int renderer_id;
+	// where the last set_instances put the instances, this buffer or a stream buffer
+	unsigned int source_id;
+	size_t source_offset;
+	size_t count;
+	size_t capacity;
+	std::vector<Instance> staging;
+};
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// LZ4 block format (no frame header, no checksums), compatible with
+// LZ4_compress_default and LZ4_decompress_safe. Fast to decode, meant for
+// asset archive entries that are inflated once on load.
+
+// greedy single pass compression of size bytes
+std::vector<unsigned char> lz4_compress(const unsigned char *data, size_t size);
+
+// Decodes a block into exactly decompressed_size bytes at out. False when
+// the block is malformed or does not decode to that size, every read and
+// write is bounds checked.
+bool lz4_decompress(const unsigned char *block, size_t block_size, unsigned char *out, size_t decompressed_size);
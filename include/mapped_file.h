@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Read only mapping of a whole file. Loaders parse headers and hand blobs
+// to GL straight from the mapping instead of reading the file into heap
+// buffers first; the pages come from the page cache and are only faulted
+// in when touched. The access pattern is passed on to the kernel with
+// madvise (a file flag on Windows) so it can read ahead accordingly.
+class MappedFile {
+public:
+	enum class Access {
+		// read once front to back, pages behind the reader may be dropped early
+		Sequential,
+		// read in no particular order, little read ahead
+		Random,
+		// all of it is needed soon, reading it in starts right away
+		WillNeed,
+	};
+
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(MappedFile &&other) noexcept;
+	MappedFile& operator=(MappedFile &&other) noexcept;
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// maps path, false when it cannot be opened or mapped. Nothing is
+	// printed, callers decide whether a missing file is an error. An empty
+	// file opens with no data.
+	bool open(const std::string &path, Access access = Access::Sequential);
+	void close();
+
+	// hints that [offset, offset + size) is needed soon, e.g. by a worker
+	// ahead of an upload on the render thread
+	void prefetch(size_t offset, size_t size) const;
+
+	[[nodiscard]] bool is_open() const;
+	[[nodiscard]] const unsigned char* get_data() const;
+	[[nodiscard]] size_t get_size() const;
+
+private:
+	const unsigned char *data = nullptr;
+	size_t size = 0;
+	bool opened = false;
+#ifdef _WIN32
+	void *mapping = nullptr;
+#endif
+};
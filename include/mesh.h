@@ -5,63 +5,125 @@
 #include <vector>
 
 #include "shader.h"
+#include "gl_state_cache.h"
+#include "vertex.h"
+#include "vertex_packing.h"
+#include "index_buffer.h"
+#include "geometry_arena.h"
+#include "instance_buffer.h"
 
 #include <glad/glad.h> // holds all OpenGL type declarations
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <span>
 #include <string>
 #include <vector>
 using namespace std;
 
-#define MAX_BONE_INFLUENCE 4
-
-struct Vertex {
-    // position
-    glm::vec3 Position;
-    // normal
-    glm::vec3 Normal;
-    // texCoords
-    glm::vec2 TexCoords;
-    // tangent
-    glm::vec3 Tangent;
-    // bitangent
-    glm::vec3 Bitangent;
-    //bone indexes which will influence this vertex
-    int m_BoneIDs[MAX_BONE_INFLUENCE];
-    //weights from each bone
-    float m_Weights[MAX_BONE_INFLUENCE];
-};
-
 struct MeshTexture {
     unsigned int id;
     string type;
     string path;
 };
 
+// vertices and indices that live elsewhere, in a mapped mesh cache or a
+// MeshData, and stay valid only as long as that does
+struct MeshView {
+    std::span<const Vertex> vertices;
+    std::span<const unsigned int> indices;
+    vector<MeshTexture> textures;
+};
+
+// how a Mesh stores its data on the GPU
+struct MeshUploadOptions {
+    // the compact formats need a decoding vertex shader, see vertex_packing.h
+    VertexFormat format = VertexFormat::Full;
+    // allows meshes with more than 65536 vertices to use 16 bit indices drawn in several ranges
+    bool splitIndexRanges = false;
+    // suballocate from the GeometryArena of the vertex layout instead of owning a VAO and buffers
+    bool sharedGeometry = false;
+};
+
 class Mesh {
 public:
-    // mesh Data
+    // mesh Data, CPU copies of the vertices and indices are only kept by the vector constructor
     vector<Vertex>       vertices;
     vector<unsigned int> indices;
     vector<MeshTexture>      textures;
+    size_t vertexCount = 0;
+    size_t indexCount = 0;
     unsigned int VAO;
+    MeshUploadOptions options;
+    // dequantization of compact positions, see vertex_packing.h
+    glm::vec3 positionOffset = glm::vec3(0.0f);
+    glm::vec3 positionScale = glm::vec3(1.0f);
+    // bytes uploaded to the vertex and index buffers
+    size_t vertexBytes = 0;
+    size_t indexBytes = 0;
+    // GL_UNSIGNED_SHORT when the mesh can be addressed with 16 bit indices
+    GLenum indexType = GL_UNSIGNED_INT;
+    unsigned int indexSize = sizeof(unsigned int);
+    vector<IndexRange> indexRanges;
+    // where the mesh starts in its buffers, non zero when they are shared
+    unsigned int baseVertex = 0;
+    size_t indexOffset = 0;
+    GeometryArena *arena = nullptr;
 
     // constructor
-    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<MeshTexture> textures)
+    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<MeshTexture> textures, const MeshUploadOptions &options = {})
+        : options(options)
     {
-        this->vertices = vertices;
-        this->indices = indices;
-        this->textures = textures;
+        this->vertices = std::move(vertices);
+        this->indices = std::move(indices);
+        this->textures = std::move(textures);
 
         // now that we have all the required data, set the vertex buffers and its attribute pointers.
-        setupMesh();
+        setupMesh(this->vertices, this->indices);
+    }
+
+    // uploads straight from the view, e.g. from a mapped mesh cache, without keeping a copy
+    Mesh(const MeshView &view, const MeshUploadOptions &options = {})
+        : textures(view.textures), options(options)
+    {
+        setupMesh(view.vertices, view.indices);
     }
 
     // render the mesh
     void Draw(Shader &shader)
     {
+        bindMaterial(shader);
+
+        // draw mesh, the VAO stays bound so the next draw of the same mesh, or of any mesh in the same arena, does not rebind it
+        GLStateCache::get().bind_vertex_array(VAO);
+        for (const IndexRange &range : indexRanges)
+        {
+            const void *offset = (void*)(uintptr_t)(indexOffset + range.first_index * indexSize);
+            const unsigned int base = baseVertex + range.base_vertex;
+            if (base == 0)
+                glDrawElements(GL_TRIANGLES, range.count, indexType, offset);
+            else
+                glDrawElementsBaseVertex(GL_TRIANGLES, range.count, indexType, offset, base);
+        }
+    }
+
+    // render the mesh once per instance, the shader reads the instance attributes described in instance_buffer.h
+    void DrawInstanced(Shader &shader, const InstanceBuffer &instances)
+    {
+        bindMaterial(shader);
+        for (const IndexRange &range : indexRanges)
+        {
+            const void *offset = (void*)(uintptr_t)(indexOffset + range.first_index * indexSize);
+            instances.draw_elements(VAO, GL_TRIANGLES, range.count, indexType, offset, baseVertex + range.base_vertex);
+        }
+    }
+
+private:
+    // binds the textures and sets the per mesh uniforms
+    void bindMaterial(Shader &shader)
+    {
+        GLStateCache& state = GLStateCache::get();
         // bind appropriate textures
         unsigned int diffuseNr  = 1;
         unsigned int specularNr = 1;
@@ -69,7 +131,6 @@ public:
         unsigned int heightNr   = 1;
         for(unsigned int i = 0; i < textures.size(); i++)
         {
-            glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
             // retrieve texture number (the N in diffuse_textureN)
             string number;
             string name = textures[i].type;
@@ -83,66 +144,82 @@ public:
                 number = std::to_string(heightNr++); // transfer unsigned int to string
 
             // now set the sampler to the correct texture unit
-            glUniform1i(glGetUniformLocation(shader.get_program(), (name + number).c_str()), i);
-            // and finally bind the texture
-            glBindTexture(GL_TEXTURE_2D, textures[i].id);
+            shader.set_int(name + number, i);
+            // and finally bind the texture, the cache skips units that already hold it
+            state.bind_texture(i, GL_TEXTURE_2D, textures[i].id);
         }
 
-        // draw mesh
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
-
-        // always good practice to set everything back to defaults once configured.
-        glActiveTexture(GL_TEXTURE0);
+        if (options.format != VertexFormat::Full)
+        {
+            shader.set_vec3("position_offset", positionOffset);
+            shader.set_vec3("position_scale", positionScale);
+        }
     }
 
-private:
     // render data 
-    unsigned int VBO, EBO;
+    // zero when the mesh lives in a GeometryArena
+    unsigned int VBO = 0, EBO = 0;
 
     // initializes all the buffer objects/arrays
-    void setupMesh()
+    void setupMesh(std::span<const Vertex> vertices, std::span<const unsigned int> indices)
     {
+        vertexCount = vertices.size();
+        indexCount = indices.size();
+
+        // pack first, the arena to use depends on the resulting layout
+        PackedVertices packed;
+        const void *vertexData = vertices.data();
+        bool skinned = false;
+        vertexBytes = vertices.size() * sizeof(Vertex);
+        if (options.format != VertexFormat::Full)
+        {
+            packed = pack_vertices(vertices, options.format);
+            positionOffset = packed.position_offset;
+            positionScale = packed.position_scale;
+            vertexData = packed.data.data();
+            vertexBytes = packed.data.size();
+            skinned = packed.layout.skinned;
+        }
+
+        PackedIndices packedIndices = pack_indices(indices, options.splitIndexRanges);
+        indexType = packedIndices.type;
+        indexSize = packedIndices.index_size;
+        indexRanges = std::move(packedIndices.ranges);
+        // 32 bit indices are uploaded as they are
+        const void *indexData = packedIndices.data.empty() ? static_cast<const void*>(indices.data()) : packedIndices.data.data();
+        indexBytes = indices.size() * indexSize;
+
+        if (options.sharedGeometry)
+        {
+            arena = &GeometryArena::shared(options.format, skinned);
+            baseVertex = arena->add_vertices(vertexData, vertices.size());
+            indexOffset = arena->add_indices(indexData, indexBytes);
+            VAO = arena->get_vertex_array();
+            return;
+        }
+
         // create buffers/arrays
         glGenVertexArrays(1, &VAO);
         glGenBuffers(1, &VBO);
         glGenBuffers(1, &EBO);
 
-        glBindVertexArray(VAO);
+        GLStateCache& state = GLStateCache::get();
+        state.bind_vertex_array(VAO);
         // load data into vertex buffers
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        state.bind_buffer(GL_ARRAY_BUFFER, VBO);
         // A great thing about structs is that their memory layout is sequential for all its items.
         // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
         // again translates to 3/2 floats which translates to a byte array.
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+        glBufferData(GL_ARRAY_BUFFER, vertexBytes, vertexData, GL_STATIC_DRAW);
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+        state.bind_buffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, indexData, GL_STATIC_DRAW);
 
         // set the vertex attribute pointers
-        // vertex Positions
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-        // vertex normals
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-        // vertex texture coords
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
-        // vertex tangent
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
-        // vertex bitangent
-        glEnableVertexAttribArray(4);
-        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
-        // ids
-        glEnableVertexAttribArray(5);
-        glVertexAttribIPointer(5, 4, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, m_BoneIDs));
-
-        // weights
-        glEnableVertexAttribArray(6);
-        glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, m_Weights));
-        glBindVertexArray(0);
+        if (options.format != VertexFormat::Full)
+            get_vertex_buffer_layout(packed.layout).apply();
+        else
+            get_full_vertex_buffer_layout().apply();
+        state.bind_vertex_array(0);
     }
 };
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "mesh.h"
+#include "virtual_file_system.h"
+
+// CPU side contents of a Mesh before it is uploaded. Texture ids are not
+// resolved yet, only type and path are set.
+struct MeshData {
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    std::vector<MeshTexture> textures;
+};
+
+MeshView view_mesh(const MeshData &mesh);
+
+// Binary cache of the meshes imported from an asset, stored next to it as
+// <asset>.meshcache. The file is a MeshCacheHeader followed by a table of
+// MeshCacheEntry, a table of MeshCacheTexture, a string table and the vertex
+// and index blobs. Blobs start on MESH_CACHE_ALIGNMENT boundaries so they can
+// be handed to glBufferData straight from a mapping of the file.
+// A cache is only used when version, vertex size, import flags, pipeline
+// flags and the hash of the source asset all match.
+constexpr std::uint32_t MESH_CACHE_VERSION = 2;
+constexpr std::uint64_t MESH_CACHE_ALIGNMENT = 64;
+
+// post import steps applied to the cached meshes, stored as pipeline_flags
+constexpr std::uint32_t MESH_PIPELINE_OPTIMIZED = 1u << 0;
+
+struct MeshCacheHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t vertex_size;
+    std::uint32_t import_flags;
+    std::uint32_t mesh_count;
+    std::uint64_t source_hash;
+    std::uint64_t texture_table_offset;
+    std::uint32_t texture_count;
+    std::uint32_t string_table_size;
+    std::uint64_t string_table_offset;
+    std::uint64_t file_size;
+    std::uint32_t pipeline_flags;
+    std::uint32_t reserved;
+};
+
+struct MeshCacheEntry {
+    std::uint64_t vertex_offset;
+    std::uint64_t index_offset;
+    std::uint32_t vertex_count;
+    std::uint32_t index_count;
+    std::uint32_t first_texture;
+    std::uint32_t texture_count;
+};
+
+struct MeshCacheTexture {
+    std::uint32_t type_offset;
+    std::uint32_t type_length;
+    std::uint32_t path_offset;
+    std::uint32_t path_length;
+};
+
+std::string get_mesh_cache_path(const std::string &asset_path);
+
+// Opens the cache through the VirtualFileSystem into file, meshes point
+// into its data: the mapped file or archive entry. False when the
+// cache is missing, stale or malformed, meshes is left empty then.
+// Without a source_hash the cache is taken as cooked ahead of time for a
+// source that is not shipped, its source hash and pipeline flags are not checked.
+bool map_mesh_cache(const std::string &cache_path,
+                    std::optional<std::uint64_t> source_hash,
+                    std::uint32_t import_flags,
+                    std::uint32_t pipeline_flags,
+                    AssetFile &file,
+                    std::vector<MeshView> &meshes);
+
+bool save_mesh_cache(const std::string &cache_path,
+                     std::uint64_t source_hash,
+                     std::uint32_t import_flags,
+                     std::uint32_t pipeline_flags,
+                     const std::vector<MeshData> &meshes);
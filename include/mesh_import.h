@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "mesh_cache.h"
+#include "virtual_file_system.h"
+
+// Model file import shared by Model and the asset cooker, no GL involved.
+// Meshes are read with assimp and kept in a mesh cache next to the model
+// (see mesh_cache.h) so later loads skip assimp entirely.
+
+// reads every mesh of the model at path, optimize runs optimize_mesh on them;
+// false after printing the importer error
+bool import_meshes(const std::string &path, bool optimize, std::vector<MeshData> &meshes);
+
+// imports path and writes its mesh cache to cache_path, for cooking ahead of time
+bool cook_meshes(const std::string &path, const std::string &cache_path, bool optimize);
+
+// Meshes of a model, either mapped from its mesh cache or imported.
+struct LoadedMeshes {
+    AssetFile cache;
+    // only filled when the model had to be imported
+    std::vector<MeshData> imported;
+    // point into cache or imported, valid while this is alive
+    std::vector<MeshView> meshes;
+    // assimp was skipped
+    bool from_cache = false;
+};
+
+// Meshes of the model at path from its mesh cache, imported and cached when
+// the cache is missing or stale. path is an asset name, see
+// VirtualFileSystem. Cooked assets hold only the cache, without the model
+// file the cache is used as is.
+bool load_meshes(const std::string &path, bool optimize, LoadedMeshes &loaded);
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "mesh_cache.h"
+#include "vertex.h"
+
+// Post import reordering of triangle lists for the GPU. The passes only
+// change the order of triangles and vertices, never the geometry.
+//  optimize_vertex_cache: Tipsify (Sander et al. 2007) for post transform
+//    vertex cache hits.
+//  optimize_overdraw: splits the cache optimized list into clusters and
+//    sorts them so outward facing clusters draw first, independent of view.
+//  optimize_vertex_fetch: renumbers vertices in first use order so vertex
+//    fetch walks memory linearly, unreferenced vertices are dropped.
+constexpr unsigned int VERTEX_CACHE_SIZE = 16;
+
+// ACMR: cache misses per triangle, 0.5 is the ideal for large regular meshes
+// ATVR: cache misses per referenced vertex, 1.0 is the ideal
+struct VertexCacheStats {
+	float acmr;
+	float atvr;
+};
+
+struct MeshOptimizationStats {
+	VertexCacheStats before;
+	VertexCacheStats after;
+	size_t triangle_count;
+};
+
+// simulates a FIFO post transform cache of cache_size entries
+VertexCacheStats analyze_vertex_cache(const std::vector<unsigned int> &indices, size_t vertex_count, unsigned int cache_size = VERTEX_CACHE_SIZE);
+
+void optimize_vertex_cache(std::vector<unsigned int> &indices, size_t vertex_count, unsigned int cache_size = VERTEX_CACHE_SIZE);
+// threshold bounds how much worse than the input the ACMR of a cluster may get
+void optimize_overdraw(std::vector<unsigned int> &indices, const std::vector<Vertex> &vertices, float threshold = 1.05f, unsigned int cache_size = VERTEX_CACHE_SIZE);
+void optimize_vertex_fetch(std::vector<unsigned int> &indices, std::vector<Vertex> &vertices);
+
+// runs the three passes in order on a triangle list
+MeshOptimizationStats optimize_mesh(MeshData &mesh);
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// One level of a MipChain, rows are tightly packed.
+struct MipLevel {
+	int width;
+	int height;
+	size_t offset;
+};
+
+// An 8 bit per channel image followed by all of its mip levels down to 1x1,
+// in one allocation so it can be handed between threads and uploaded at once.
+struct MipChain {
+	int channels;
+	bool srgb;
+	std::vector<unsigned char> data;
+	std::vector<MipLevel> levels;
+};
+
+// Builds the chain with a 2x2 box filter, a level ignores the last row or
+// column of an odd sized parent. With srgb the colour channels of 3 and 4
+// channel images are averaged in linear space so mips keep their brightness,
+// alpha is always linear. Pure CPU work, safe on any thread.
+MipChain generate_mip_chain(const unsigned char *pixels, int width, int height, int channels, bool srgb);
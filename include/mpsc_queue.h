@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+// Unbounded lock-free queue for many producers and a single consumer.
+// Producers push onto an intrusive stack with a CAS, the consumer detaches
+// the whole stack with one exchange and reverses it to restore FIFO order.
+template <typename T>
+class MpscQueue {
+public:
+	MpscQueue() : head(nullptr) {}
+	~MpscQueue();
+
+	MpscQueue(const MpscQueue&) = delete;
+	MpscQueue& operator=(const MpscQueue&) = delete;
+
+	// safe to call from any thread
+	void push(T value);
+
+	// consumer only, calls fn(T&&) for every element pushed so far in push
+	// order and returns how many there were
+	template <typename F>
+	unsigned int consume_all(F &&fn);
+
+private:
+	struct Node {
+		T value;
+		Node *next;
+	};
+
+	std::atomic<Node*> head;
+};
+
+template <typename T>
+MpscQueue<T>::~MpscQueue()
+{
+	Node *node = head.load(std::memory_order_acquire);
+	while (node) {
+		Node *next = node->next;
+		delete node;
+		node = next;
+	}
+}
+
+template <typename T>
+void MpscQueue<T>::push(T value)
+{
+	Node *node = new Node{std::move(value), head.load(std::memory_order_relaxed)};
+	while (!head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed))
+		;
+}
+
+template <typename T>
+template <typename F>
+unsigned int MpscQueue<T>::consume_all(F &&fn)
+{
+	Node *node = head.exchange(nullptr, std::memory_order_acquire);
+
+	Node *reversed = nullptr;
+	while (node) {
+		Node *next = node->next;
+		node->next = reversed;
+		reversed = node;
+		node = next;
+	}
+
+	unsigned int count = 0;
+	while (reversed) {
+		Node *next = reversed->next;
+		fn(std::move(reversed->value));
+		delete reversed;
+		reversed = next;
+		++count;
+	}
+	return count;
+}
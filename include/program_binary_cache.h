@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <initializer_list>
+#include <string_view>
+
+// On disk cache of linked programs as returned by glGetProgramBinary, so
+// later launches skip compiling and linking GLSL. Each program is stored in
+// PROGRAM_BINARY_CACHE_DIRECTORY as <key>.bin, a ProgramBinaryHeader
+// followed by the binary. A binary is only good for the driver that wrote
+// it: the key covers the vendor, renderer and version strings, and the
+// driver may still reject it, callers compile from source then and save
+// the result over the rejected entry. Contexts without program binaries
+// (GLExtensions::get_program_binary) neither load nor store anything.
+constexpr std::uint32_t PROGRAM_BINARY_CACHE_VERSION = 1;
+constexpr const char *PROGRAM_BINARY_CACHE_DIRECTORY = "shader_cache";
+
+struct ProgramBinaryHeader {
+	char magic[8];
+	std::uint32_t version;
+	// binaryFormat reported by glGetProgramBinary
+	std::uint32_t format;
+	std::uint64_t key;
+	std::uint64_t size;
+};
+
+// hash of every stage's source text and of the current context's driver
+std::uint64_t get_program_binary_key(std::initializer_list<std::string_view> sources);
+
+// linked program from the cache, 0 when there is no usable entry
+unsigned int load_program_binary(std::uint64_t key);
+
+// stores a program linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set,
+// false after printing why when it cannot be written
+bool save_program_binary(std::uint64_t key, unsigned int program);
@@ -7,13 +7,59 @@
 
 #include <glad/glad.h>
 
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <vector>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 
 #include <glm/glm.hpp>
 
+using UniformHash = std::uint64_t;
+
+constexpr UniformHash uniform_hash_seed = 0xcbf29ce484222325ull;
+
+// FNV-1a hash of a uniform name. Being constexpr, hashes of string literals
+// can be computed at compile time and used to look up uniforms by handle.
+// Passing the result of a previous call as seed hashes a name piecewise.
+constexpr UniformHash hash_uniform_name(std::string_view name, UniformHash seed = uniform_hash_seed)
+{
+    UniformHash hash = seed;
+    for (const char c : name) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+// Hash of "array[index].member" computed without building the string.
+constexpr UniformHash hash_indexed_uniform_name(std::string_view array, unsigned int index, std::string_view member)
+{
+    char digits[10] = {};
+    int count = 0;
+    do {
+        digits[count++] = static_cast<char>('0' + index % 10);
+        index /= 10;
+    } while (index);
+
+    UniformHash hash = hash_uniform_name(array);
+    hash = hash_uniform_name("[", hash);
+    while (count)
+        hash = hash_uniform_name(std::string_view(&digits[--count], 1), hash);
+    hash = hash_uniform_name("].", hash);
+    return hash_uniform_name(member, hash);
+}
+
+// Resolved location of an active uniform. Obtained once via Shader::get_uniform
+// and then passed to the set_* overloads, which skip any name lookup.
+struct UniformHandle {
+    int location = -1;
+
+    [[nodiscard]] bool is_valid() const { return location >= 0; }
+};
+
 class Shader {
 public:
     Shader(const std::string& vertex_path, const std::string& pixel_path);
@@ -30,8 +76,38 @@ public:
 
     void set_mat3(const std::string& name, const glm::mat3 mat) const;
 
+    // invalid for names whose hash collides with another active uniform, look those up by name
+    [[nodiscard]] UniformHandle get_uniform(UniformHash hash) const;
+    // falls back to glGetUniformLocation for names with a colliding hash
+    [[nodiscard]] UniformHandle get_uniform(std::string_view name) const;
+    [[nodiscard]] UniformHandle get_uniform(std::string_view array, unsigned int index, std::string_view member) const;
+
+    void set_bool(UniformHandle handle, bool value) const;
+    void set_int(UniformHandle handle, int value) const;
+    void set_float(UniformHandle handle, float value) const;
+    void set_vec2(UniformHandle handle, const glm::vec2 &vec) const;
+    void set_vec3(UniformHandle handle, const glm::vec3 &vec) const;
+    void set_vec4(UniformHandle handle, const glm::vec4 &vec) const;
+    void set_mat3(UniformHandle handle, const glm::mat3 &mat) const;
+    void set_mat4(UniformHandle handle, const glm::mat4 &mat) const;
+
+    // attaches the named uniform block to a binding point, blocks not used by the program are ignored
+    void set_uniform_block_binding(const std::string &block_name, unsigned int binding) const;
+
 private:
+    struct UniformSlot {
+        UniformHash hash;
+        int location;
+        // several active uniforms share the hash, location belongs to only one of them
+        bool collides;
+    };
+
+    void cache_uniforms();
+    [[nodiscard]] const UniformSlot* find_uniform_slot(UniformHash hash) const;
+
     unsigned int program_id;
+    // open addressing table with linear probing, capacity is a power of two
+    std::vector<UniformSlot> uniform_slots;
 };
 
 #endif //LEARN_OPEN_GL_SHADER_H
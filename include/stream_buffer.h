@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <glad/glad.h>
+
+// Ring of frame regions in one buffer for data rewritten every frame:
+// instances, uniform blocks, dynamic vertices. With buffer storage the
+// buffer is mapped once, persistent and coherent, and allocations point
+// straight into it. Each region is fenced when its frame ends and waited
+// on only when the ring comes back around, so writing never stalls on
+// draws from the frames still in flight.
+//
+// Without buffer storage allocations point into a CPU copy, flush()
+// uploads what was written so far in the frame with glBufferSubData.
+//
+//	stream.begin_frame();
+//	StreamBuffer::Allocation a = stream.allocate(sizeof(CameraBlock), StreamBuffer::get_uniform_alignment());
+//	new (a.data) CameraBlock(...);
+//	stream.flush();
+//	stream.bind_range(GL_UNIFORM_BUFFER, CAMERA_BLOCK_BINDING, a.offset, sizeof(CameraBlock));
+//	... draws ...
+//	stream.end_frame();
+class StreamBuffer {
+public:
+	struct Allocation {
+		// null when the frame region is full
+		void *data;
+		// from the start of the buffer, for attribute pointers and bind_range
+		size_t offset;
+	};
+
+	static constexpr unsigned int DEFAULT_REGION_COUNT = 3;
+
+	explicit StreamBuffer(size_t region_size, unsigned int region_count = DEFAULT_REGION_COUNT);
+	~StreamBuffer();
+
+	StreamBuffer(const StreamBuffer&) = delete;
+	StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+	// waits until the GPU is done with the next region and makes it current
+	void begin_frame();
+	// fences the current region, everything allocated in the frame must have been drawn
+	void end_frame();
+
+	// space for size bytes in the current region, valid until the region comes around again
+	Allocation allocate(size_t size, size_t alignment = 16);
+	// makes the writes since the last flush visible to the GPU, a no op when persistently mapped
+	void flush();
+
+	void bind(GLenum target) const;
+	void bind_range(GLenum target, unsigned int index, size_t offset, size_t size) const;
+
+	[[nodiscard]] unsigned int get_renderer_id() const;
+	[[nodiscard]] bool is_persistent() const;
+	// times begin_frame had to wait for the GPU, if it keeps growing add regions
+	[[nodiscard]] unsigned int get_stall_count() const;
+
+	// GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+	static size_t get_uniform_alignment();
+
+private:
+	unsigned int renderer_id;
+	size_t region_size;
+	unsigned int region_count;
+	unsigned int region;
+	size_t head;
+	size_t flushed;
+	unsigned int stall_count;
+	std::byte *mapped;
+	std::vector<std::byte> staging;
+	std::vector<GLsync> fences;
+};
@@ -2,16 +2,25 @@
 
 #include <string>
 
+class AsyncTextureLoader;
+
 class Texture {
 public:
 	void bind() const;
+	// binds to the given texture unit, unit is zero based
+	void bind(unsigned int unit) const;
 	void unbind() const;
 	Texture(const std::string &image_src_path);
+	// shows a placeholder until loader.upload_pending() uploads the image,
+	// the loader has to outlive the texture
+	Texture(const std::string &image_src_path, AsyncTextureLoader &loader);
 	~Texture();
 
 private:
-	void load_image(const std::string& image_src_path) const;
+	// 0 when the image could not be loaded
+	static unsigned int load_image(const std::string& image_src_path);
 
 private:
 	unsigned int renderer_id;
+	AsyncTextureLoader *loader;
 };
\ No newline at end of file
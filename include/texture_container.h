@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "mip_generator.h"
+#include "virtual_file_system.h"
+
+// Block compressed formats the loader and the texture encoder know about.
+// Every format encodes 4x4 pixel blocks, partial blocks at the edges of a
+// level are padded to a full block.
+enum class BlockFormat : unsigned char {
+	// RGB, 4 bpp, colour maps without alpha
+	BC1,
+	// RGBA, 8 bpp, BC1 colour plus an interpolated alpha block
+	BC3,
+	// two independent channels, 8 bpp, tangent space normal maps (xy)
+	BC5,
+	// RGBA, 8 bpp, much better colour quality than BC1 and BC3
+	BC7,
+};
+
+// bytes per 4x4 block
+size_t get_block_size(BlockFormat format);
+size_t get_compressed_level_size(BlockFormat format, int width, int height);
+
+// A block compressed image with its mip levels, largest first. The encoder
+// stores the levels back to back in data, a read image leaves them in the
+// mapped file or archive entry. MipLevel::offset points at each of them.
+struct CompressedImage {
+	BlockFormat format;
+	// the encoder filtered the mips in linear space and the file is tagged
+	// sRGB, the loader still samples it the way the caller asks for
+	bool srgb;
+	std::vector<unsigned char> data;
+	AssetFile file;
+	std::vector<MipLevel> levels;
+
+	[[nodiscard]] const unsigned char* get_level_data(size_t level) const;
+};
+
+// Opens a DDS (legacy DXT1/DXT5/ATI2 or DX10 header) or an uncompressed
+// KTX2 file holding a single 2D BC1/BC3/BC5/BC7 image through the
+// VirtualFileSystem, nothing is copied out of the mapping. Prints the
+// reason and returns false for anything else.
+bool read_compressed_image(const std::string &path, CompressedImage &image);
+// DDS with a DX10 header, what the texture encoder writes
+bool write_dds(const std::string &path, const CompressedImage &image);
+
+// stbi_load from the VirtualFileSystem instead of buffered stdio, free the
+// pixels with stbi_image_free. Null when the file cannot be read or decoded.
+unsigned char* decode_image_file(const std::string &path, int &width, int &height, int &channels, int desired_channels = 0);
+
+// image_path itself when it is a .dds or .ktx2 file, otherwise the .ktx2 or
+// .dds file next to it with the same name, empty when there is none.
+// Looked up through the VirtualFileSystem.
+std::string find_compressed_texture(const std::string &image_path);
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+
+class AsyncTextureLoader;
+
+// Process wide table of the 2D textures loaded from image files, keyed by
+// canonical path and import options. Each texture is decoded and uploaded
+// once no matter how many models or materials reference it, and deleted
+// when the last reference is released. GL thread only.
+class TextureRegistry {
+public:
+	struct Options {
+		// sample the image as sRGB and let GL linearize it
+		bool gamma;
+		// channels a decoded image is converted to, 0 keeps the file's.
+		// KTX2/DDS files keep their block format.
+		int channels;
+	};
+
+	static TextureRegistry& get();
+
+	// returns the texture for image_path and takes a reference on it. New
+	// textures are decoded by loader when given, synchronously otherwise.
+	unsigned int acquire(const std::string &image_path, Options options = {}, AsyncTextureLoader *loader = nullptr);
+	// drops a reference taken by acquire, the last one deletes the texture
+	void release(unsigned int texture_id);
+
+	[[nodiscard]] size_t size() const;
+
+private:
+	struct Entry {
+		unsigned int texture_id;
+		unsigned int references;
+		AsyncTextureLoader *loader;
+	};
+
+	TextureRegistry() = default;
+
+	static std::string make_key(const std::string &image_path, Options options);
+
+	std::unordered_map<std::string, Entry> entries;
+	// reverse index so release does not have to search the entries
+	std::unordered_map<unsigned int, std::string> keys;
+};
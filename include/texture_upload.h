@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+
+#include <glad/glad.h>
+
+#include "mip_generator.h"
+#include "texture_container.h"
+
+// GL formats of an 8 bit per channel image.
+struct TextureFormat {
+	GLenum format;
+	// sized, as immutable storage requires; sRGB only exists for 3 and 4 channels
+	GLenum internal_format;
+};
+
+TextureFormat get_texture_format(int channels, bool srgb);
+// BC5 has no sRGB variant and ignores srgb
+GLenum get_compressed_internal_format(BlockFormat format, bool srgb);
+// true when the context can sample format
+bool is_block_format_supported(BlockFormat format);
+
+// Creates an immutable 2D texture holding every level of chain, nothing is
+// filtered on the GPU. With direct state access nothing is bound, otherwise
+// the texture ends up bound to GL_TEXTURE_2D of the active unit through the
+// GLStateCache.
+unsigned int create_texture_2d(const MipChain &chain);
+// same for an 8 bit image, its mip chain is generated on the calling thread
+unsigned int create_texture_2d(int width, int height, int channels, bool srgb, const unsigned char *pixels);
+// same for a block compressed image, srgb picks the internal format
+unsigned int create_texture_2d(const CompressedImage &image, bool srgb);
+
+// Loads the KTX2/DDS file find_compressed_texture finds for image_path.
+// Returns 0 when there is none or it cannot be used, the caller then
+// decodes image_path itself.
+unsigned int load_compressed_texture(const std::string &image_path, bool srgb);
+
+// repeat wrapping, linear magnification and the given minification filter
+void set_texture_sampling(unsigned int texture, GLenum min_filter);
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fixed set of worker threads consuming a FIFO of tasks. Tasks must not
+// touch GL, the context is only current on the render thread.
+class ThreadPool {
+public:
+	explicit ThreadPool(unsigned int thread_count = std::thread::hardware_concurrency());
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	template <typename F>
+	std::future<std::invoke_result_t<F>> submit(F &&task);
+
+	// runs body(i) for every i in [0, count) on the workers and the calling
+	// thread, returns once all iterations are done
+	void parallel_for(size_t count, const std::function<void(size_t)> &body);
+
+	[[nodiscard]] unsigned int get_thread_count() const;
+
+	// pool shared by the loaders, sized to the number of hardware threads
+	static ThreadPool& shared();
+
+private:
+	void worker_loop();
+
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>> tasks;
+	std::mutex mutex;
+	std::condition_variable task_available;
+	bool stopping;
+};
+
+template <typename F>
+std::future<std::invoke_result_t<F>> ThreadPool::submit(F &&task)
+{
+	using Result = std::invoke_result_t<F>;
+	// std::function needs a copyable target, so the task lives behind a shared_ptr
+	auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+	std::future<Result> result = packaged->get_future();
+	{
+		std::lock_guard lock(mutex);
+		tasks.emplace_back([packaged] { (*packaged)(); });
+	}
+	task_available.notify_one();
+	return result;
+}
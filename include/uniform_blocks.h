@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+
+#include <glm/glm.hpp>
+
+// Binding points of the uniform blocks shared by all shaders.
+constexpr unsigned int CAMERA_BLOCK_BINDING = 0;
+constexpr unsigned int LIGHTS_BLOCK_BINDING = 1;
+constexpr unsigned int MATERIAL_BLOCK_BINDING = 2;
+
+constexpr unsigned int MAX_POINT_LIGHTS = 4;
+
+// The structs below mirror the std140 layout of the GLSL blocks of the same
+// name: vec3 members start on a 16 byte boundary and may be followed by a
+// float filling their padding, structs and array elements are rounded up to
+// a multiple of 16 bytes. Keep the member order in sync with the shaders.
+#define STD140_VEC3 alignas(16) glm::vec3
+
+struct DirLightStd140 {
+	STD140_VEC3 direction;
+	STD140_VEC3 ambient;
+	STD140_VEC3 diffuse;
+	STD140_VEC3 specular;
+};
+
+struct PointLightStd140 {
+	STD140_VEC3 position;
+	float constant;
+	STD140_VEC3 ambient;
+	float linear;
+	STD140_VEC3 diffuse;
+	float quadratic;
+	STD140_VEC3 specular;
+};
+
+struct SpotLightStd140 {
+	STD140_VEC3 position;
+	float cut_off;
+	STD140_VEC3 direction;
+	float outer_cut_off;
+	STD140_VEC3 ambient;
+	float constant;
+	STD140_VEC3 diffuse;
+	float linear;
+	STD140_VEC3 specular;
+	float quadratic;
+};
+
+struct CameraBlock {
+	glm::mat4 view;
+	glm::mat4 projection;
+	STD140_VEC3 view_pos;
+};
+
+struct LightsBlock {
+	DirLightStd140 dir_light;
+	PointLightStd140 point_lights[MAX_POINT_LIGHTS];
+	SpotLightStd140 spot_light;
+	int num_point_lights;
+};
+
+struct alignas(16) MaterialBlock {
+	float shininess;
+};
+
+#undef STD140_VEC3
+
+static_assert(sizeof(DirLightStd140) == 64);
+static_assert(sizeof(PointLightStd140) == 64);
+static_assert(offsetof(PointLightStd140, constant) == 12);
+static_assert(sizeof(SpotLightStd140) == 80);
+static_assert(offsetof(SpotLightStd140, quadratic) == 76);
+static_assert(offsetof(CameraBlock, view_pos) == 128);
+static_assert(offsetof(LightsBlock, point_lights) == 64);
+static_assert(offsetof(LightsBlock, spot_light) == 320);
+static_assert(offsetof(LightsBlock, num_point_lights) == 400);
+static_assert(sizeof(MaterialBlock) == 16);
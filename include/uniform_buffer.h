@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+
+class UniformBuffer {
+public:
+	// allocates size bytes and attaches the buffer to the given uniform block binding point
+	UniformBuffer(size_t size, unsigned int binding);
+	~UniformBuffer();
+	void bind() const;
+	void unbind() const;
+	void set_data(const void *data, size_t size, size_t offset = 0) const;
+
+	template <typename T>
+	void set_data(const T &block) const
+	{
+		set_data(&block, sizeof(T));
+	}
+
+	unsigned int get_binding() const;
+
+private:
+	unsigned int renderer_id;
+	unsigned int binding;
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+
+#include "shader.h"
+
+// String literal usable as a template argument.
+template <std::size_t N>
+struct UniformNameLiteral {
+	constexpr UniformNameLiteral(const char (&str)[N])
+	{
+		for (std::size_t i = 0; i < N; ++i)
+			value[i] = str[i];
+	}
+
+	[[nodiscard]] constexpr std::string_view view() const { return {value, N - 1}; }
+
+	char value[N];
+};
+
+constexpr std::size_t count_decimal_digits(std::size_t n)
+{
+	std::size_t digits = 1;
+	while (n /= 10)
+		++digits;
+	return digits;
+}
+
+// "Array[Index].Member" built at compile time, e.g.
+// IndexedUniformName<"point_lights", 2, "constant">::c_str() == "point_lights[2].constant".
+// Together with the precomputed hash this lets per-element uniform updates
+// run without formatting or allocating any strings.
+template <UniformNameLiteral Array, std::size_t Index, UniformNameLiteral Member>
+struct IndexedUniformName {
+	static constexpr std::size_t length =
+		Array.view().size() + count_decimal_digits(Index) + Member.view().size() + 3;
+
+	static constexpr std::array<char, length + 1> value = [] {
+		std::array<char, length + 1> name{};
+		std::size_t pos = 0;
+		for (const char c : Array.view())
+			name[pos++] = c;
+		name[pos++] = '[';
+		pos += count_decimal_digits(Index);
+		for (std::size_t i = Index, digit = pos; digit-- > pos - count_decimal_digits(Index); i /= 10)
+			name[digit] = static_cast<char>('0' + i % 10);
+		name[pos++] = ']';
+		name[pos++] = '.';
+		for (const char c : Member.view())
+			name[pos++] = c;
+		name[pos] = '\0';
+		return name;
+	}();
+
+	static constexpr UniformHash hash = hash_uniform_name({value.data(), length});
+
+	[[nodiscard]] static constexpr const char* c_str() { return value.data(); }
+	[[nodiscard]] static constexpr std::string_view view() { return {value.data(), length}; }
+};
@@ -5,9 +5,12 @@
 #ifndef LEARN_OPEN_GL_INCLUDE_UTILITY_H
 #define LEARN_OPEN_GL_INCLUDE_UTILITY_H
 
+#include <cstdint>
 #include <string>
 #include <glm/vec3.hpp>
 
+#include "gl_debug.h"
+
 #include "GLFW/glfw3.h"
 
 class Camera;
@@ -19,7 +22,7 @@ struct GlfwContainer {
 
 void gl_clear_error();
 
-bool gl_log_call(const std::string& function_name, const std::string& filename, unsigned int line);
+bool gl_log_call(const char* function_name, const char* filename, unsigned int line);
 
 #ifdef _WIN32
 #define ASSERT(x) if (!(x)) __debugbreak()
@@ -28,9 +31,31 @@ bool gl_log_call(const std::string& function_name, const std::string& filename,
 #define ASSERT(x) if (!(x)) raise(SIGTRAP)
 #endif
 
-#define GL_CALL(x) gl_clear_error(); \
-    x;                               \
-    ASSERT(gl_log_call(#x, __FILE__, __LINE__))
+// GL_CALL_CHECKS selects what GL_CALL does around every call:
+// 0 - nothing, the call is issued as is
+// 1 - glGetError is polled before and after the call
+// 2 - the call site is recorded for the KHR_debug callback (see gl_debug.h),
+//     errors are reported by the driver and cost nothing when there are none
+// It is set by the GL_CALL_CHECKS CMake cache variable; when building
+// without it checks follow NDEBUG.
+#ifndef GL_CALL_CHECKS
+#ifdef NDEBUG
+#define GL_CALL_CHECKS 0
+#else
+#define GL_CALL_CHECKS 1
+#endif
+#endif
+
+#if GL_CALL_CHECKS == 1
+#define GL_CALL(x) do { gl_clear_error(); \
+    x;                                    \
+    ASSERT(gl_log_call(#x, __FILE__, __LINE__)); } while (0)
+#elif GL_CALL_CHECKS == 2
+#define GL_CALL(x) do { GlCallSiteScope gl_call_site_scope(#x, __FILE__, __LINE__); \
+    x; } while (0)
+#else
+#define GL_CALL(x) x
+#endif
 
 glm::vec3 calc_normal(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c);
 
@@ -57,14 +82,6 @@ std::string format(const std::string & fmt, Arg value, Args ...args)
 	return out.str();
 }
 
-void APIENTRY gl_debug_message_callback(int source,
-                                        int type,
-                                        unsigned int severity,
-                                        int length,
-                                        const char *message,
-                                        const void *user_param);
-
 void gl_print_debug_info();
-void gl_enable_debug_output();
 
 #endif //LEARN_OPEN_GL_INCLUDE_UTILITY_H
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "index_buffer.h"
 #include "vertex_buffer.h"
 #include "vertex_buffer_layout.h"
 
@@ -10,6 +11,8 @@ public:
 	void bind() const;
 	void unbind() const;
 	void add_buffer(const VertexBuffer& vb, const VertexBufferLayout& vbl);
+	void set_index_buffer(const IndexBuffer& ib);
+	[[nodiscard]] unsigned int get_renderer_id() const;
 
 private:
 	unsigned int renderer_id;
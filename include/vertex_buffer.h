@@ -1,11 +1,14 @@
 #pragma once
 
+#include <cstddef>
+
 class VertexBuffer {
 public:
 	VertexBuffer(const void *data, size_t size);
 	~VertexBuffer();
 	void bind() const;
 	void unbind() const;
+	[[nodiscard]] unsigned int get_renderer_id() const;
 
 private:
 	unsigned int renderer_id;
@@ -1,41 +1,137 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
 #include <vector>
 #include <glad/glad.h>
 
+// How the shader sees an attribute.
+enum class AttributeKind : unsigned char {
+	// floats as is, integers converted to float
+	Float,
+	// integers mapped to [0, 1] (unsigned) or [-1, 1] (signed)
+	Normalized,
+	// integers read as int/uint, glVertexAttribIPointer
+	Integer,
+};
+
+// half float component, the bits come from float_to_half
+struct Half {
+	std::uint16_t bits;
+};
+
+// GL type enum of a vertex component type
+template <typename T>
+struct GLType {
+	static_assert(sizeof(T) == 0, "no GL vertex attribute type for this component type");
+};
+template <> struct GLType<float> { static constexpr GLenum value = GL_FLOAT; };
+template <> struct GLType<Half> { static constexpr GLenum value = GL_HALF_FLOAT; };
+template <> struct GLType<std::int8_t> { static constexpr GLenum value = GL_BYTE; };
+template <> struct GLType<std::uint8_t> { static constexpr GLenum value = GL_UNSIGNED_BYTE; };
+template <> struct GLType<std::int16_t> { static constexpr GLenum value = GL_SHORT; };
+template <> struct GLType<std::uint16_t> { static constexpr GLenum value = GL_UNSIGNED_SHORT; };
+template <> struct GLType<std::int32_t> { static constexpr GLenum value = GL_INT; };
+template <> struct GLType<std::uint32_t> { static constexpr GLenum value = GL_UNSIGNED_INT; };
+
+// One attribute, counts above 4 take count / 4 consecutive locations of
+// 4 components each, e.g. a mat4 as four vec4 columns.
 struct VertexBufferElement
 {
+	unsigned int location;
 	unsigned int count;
 	unsigned int type;
-	unsigned char normalized;
-	static unsigned int get_type_size(int i);
+	AttributeKind kind;
+	unsigned int offset;
+	static unsigned int get_type_size(unsigned int type);
 };
 
+template <typename Component, AttributeKind Kind>
+constexpr void check_vertex_component()
+{
+	static_assert(Kind == AttributeKind::Float || std::is_integral_v<Component>,
+		"normalized and integer attributes need integer components");
+	(void)GLType<Component>::value;
+}
+
+template <typename Component, typename Member, AttributeKind Kind>
+constexpr VertexBufferElement make_vertex_element(unsigned int location, size_t offset)
+{
+	check_vertex_component<Component, Kind>();
+	static_assert(sizeof(Member) % sizeof(Component) == 0, "member is not made of Component values");
+	return {location, static_cast<unsigned int>(sizeof(Member) / sizeof(Component)), GLType<Component>::value,
+		Kind, static_cast<unsigned int>(offset)};
+}
+
+// element for a member of a vertex struct, usable in constexpr arrays:
+//	constexpr VertexBufferElement elements[] = {
+//		VERTEX_ELEMENT(0, Vertex, Position, float, AttributeKind::Float),
+//		VERTEX_ELEMENT(5, Vertex, m_BoneIDs, int, AttributeKind::Integer),
+//	};
+#define VERTEX_ELEMENT(location, Struct, member, Component, kind) \
+	make_vertex_element<Component, decltype(Struct::member), kind>(location, offsetof(Struct, member))
+
 class VertexBufferLayout
 {
 public:
 	VertexBufferLayout();
+	// fixed layout, the elements carry their own locations and offsets
+	VertexBufferLayout(std::span<const VertexBufferElement> elements, unsigned int stride, unsigned int divisor = 0);
 	~VertexBufferLayout();
 
+	// appends count components of T right after the previous element, at the next free location
 	template <typename T>
 	void add_element(unsigned int count);
+	template <typename T>
+	void add_normalized(unsigned int count);
+	template <typename T>
+	void add_integer(unsigned int count);
+	// bytes the shader does not read
+	void add_padding(unsigned int size);
+	// location of the next appended element
+	void set_next_location(unsigned int location);
+	// 0 advances per vertex, n every n instances
+	void set_divisor(unsigned int divisor);
+
 	const std::vector<VertexBufferElement>& get_elements() const;
 	unsigned int get_stride() const;
+	unsigned int get_divisor() const;
+
+	// enables the attributes and points them at the bound GL_ARRAY_BUFFER,
+	// base_offset bytes in; the vertex array to set up has to be bound
+	void apply(size_t base_offset = 0) const;
+	// direct state access version, attaches buffer to vertex_array at binding
+	// and points the attributes at it without binding either of them
+	void apply(unsigned int vertex_array, unsigned int binding, unsigned int buffer, size_t base_offset = 0) const;
 
 private:
+	void add(unsigned int count, unsigned int type, AttributeKind kind);
+
 	std::vector<VertexBufferElement> elements;
 	unsigned int stride;
+	unsigned int divisor;
+	unsigned int next_location;
 
 };
 
 template <typename T>
 void VertexBufferLayout::add_element(unsigned int count)
 {
-	static_assert(false);
+	check_vertex_component<T, AttributeKind::Float>();
+	add(count, GLType<T>::value, AttributeKind::Float);
 }
 
-template <>
-inline void VertexBufferLayout::add_element<float>(unsigned int count)
+template <typename T>
+void VertexBufferLayout::add_normalized(unsigned int count)
+{
+	check_vertex_component<T, AttributeKind::Normalized>();
+	add(count, GLType<T>::value, AttributeKind::Normalized);
+}
+
+template <typename T>
+void VertexBufferLayout::add_integer(unsigned int count)
 {
-	elements.emplace_back(count, static_cast<unsigned int>(GL_FLOAT), static_cast<unsigned char>(GL_FALSE));
-	stride += VertexBufferElement::get_type_size(GL_FLOAT) * count;
-}
\ No newline at end of file
+	check_vertex_component<T, AttributeKind::Integer>();
+	add(count, GLType<T>::value, AttributeKind::Integer);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "vertex.h"
+#include "vertex_buffer_layout.h"
+
+// GPU vertex formats a Mesh can be uploaded in.
+//  Full: Vertex as is, 88 bytes.
+//  Compact: float position, octahedral snorm16 normal and tangent, half
+//    float uv, 28 bytes.
+//  CompactQuantized: as Compact with the position stored as unorm16 inside
+//    the mesh bounds, 20 bytes.
+// Skinned meshes add 8 bit bone ids and weights (8 bytes) to either compact
+// format. The packed attributes are laid out as
+//  0 position    vec4, xyz position (quantized or not), w bitangent sign as 0 or 1
+//  1 normal and tangent  vec4 snorm, xy octahedral normal, zw octahedral tangent
+//  2 uv          vec2 half float
+//  5 bone ids    uvec4 (skinned only)
+//  6 weights     vec4 unorm8 (skinned only)
+// Vertex shaders decode the position as position_offset + in.xyz * position_scale.
+enum class VertexFormat {
+	Full,
+	Compact,
+	CompactQuantized,
+};
+
+struct PackedVertexLayout {
+	unsigned int stride;
+	unsigned int position_offset;
+	unsigned int normal_tangent_offset;
+	unsigned int tex_coords_offset;
+	unsigned int bone_ids_offset;
+	unsigned int weights_offset;
+	bool quantized_positions;
+	bool skinned;
+};
+
+struct PackedVertices {
+	std::vector<unsigned char> data;
+	PackedVertexLayout layout;
+	glm::vec3 position_offset;
+	glm::vec3 position_scale;
+};
+
+std::uint16_t float_to_half(float value);
+// maps a unit vector onto the octahedron and stores it as two snorm16 values
+void oct_encode_snorm16(const glm::vec3 &v, std::int16_t out[2]);
+
+// layout pack_vertices produces for a compact format
+PackedVertexLayout get_packed_vertex_layout(VertexFormat format, bool skinned);
+// format has to be one of the compact ones
+PackedVertices pack_vertices(std::span<const Vertex> vertices, VertexFormat format);
+// attributes 0, 1, 2 (and 5, 6 when skinned) of a compact format
+VertexBufferLayout get_vertex_buffer_layout(const PackedVertexLayout &layout);
+// VertexFormat::Full, attributes 0 to 6 straight from Vertex
+VertexBufferLayout get_full_vertex_buffer_layout();
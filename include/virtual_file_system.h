@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "asset_archive.h"
+#include "mapped_file.h"
+
+// Contents of a file opened through the VirtualFileSystem: a mapped loose
+// file, a stored archive entry used in place or a compressed entry inflated
+// into memory. The data does not move when the AssetFile does.
+class AssetFile {
+public:
+	AssetFile() = default;
+	AssetFile(AssetFile &&other) noexcept;
+	AssetFile& operator=(AssetFile &&other) noexcept;
+	AssetFile(const AssetFile&) = delete;
+	AssetFile& operator=(const AssetFile&) = delete;
+
+	void close();
+
+	[[nodiscard]] bool is_open() const;
+	[[nodiscard]] const unsigned char* get_data() const;
+	[[nodiscard]] size_t get_size() const;
+
+private:
+	friend class VirtualFileSystem;
+
+	MappedFile mapping;
+	std::vector<unsigned char> inflated;
+	const unsigned char *data = nullptr;
+	size_t size = 0;
+	bool opened = false;
+};
+
+// Resolves asset names ("container2.png", "backpack/backpack.obj") against
+// the mounted archives and directories, in the order they were mounted.
+// Names that no mount has are opened as plain paths, so code that is given
+// real paths, like the offline tools, works without mounting anything.
+// Mount before loading: lookups may run on loader threads and are not
+// synchronized with mounting.
+class VirtualFileSystem {
+public:
+	static VirtualFileSystem& get();
+
+	// false after printing why when the archive cannot be opened
+	bool mount_archive(const std::string &path);
+	// false when there is no such directory
+	bool mount_directory(const std::string &path);
+	// Mounts assets.pak and the assets directory next to the working
+	// directory or up to three of its parents, the first place that has
+	// either wins and its archive goes ahead of its loose files. The demos
+	// run from the build tree, which has both when ASSET_ARCHIVE is on.
+	bool mount_assets();
+	void unmount_all();
+
+	// false when name is nowhere to be found
+	bool open(const std::string &name, AssetFile &file, MappedFile::Access access = MappedFile::Access::Sequential) const;
+	[[nodiscard]] bool exists(const std::string &name) const;
+	// the loose file name refers to, for code that opens files itself
+	// (assimp, audio); name itself when no mounted directory has it
+	[[nodiscard]] std::string resolve(const std::string &name) const;
+
+private:
+	struct Mount {
+		// null for a directory
+		std::unique_ptr<AssetArchive> archive;
+		std::string directory;
+	};
+
+	VirtualFileSystem() = default;
+
+	std::vector<Mount> mounts;
+};
@@ -6,7 +6,9 @@
 
 #include "shader.h"
 #include "stb_image.h"
+#include "texture_container.h"
 #include "utility.h"
+#include "virtual_file_system.h"
 
 struct InputData {
     bool toggle_fill_mode;
@@ -57,6 +59,7 @@ int main()
         std::cerr << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
+    VirtualFileSystem::get().mount_assets();
 
     Shader shader("4.1.shader.vs", "4.1.shader.fs");
 
@@ -94,9 +97,9 @@ int main()
     int32_t width;
     int32_t height;
     int32_t nr_channels;
-    unsigned char* data = stbi_load("../assets/container.jpg", &width, &height, &nr_channels, 0);
+    unsigned char* data = decode_image_file("container.jpg", width, height, nr_channels);
     if (!data)
-        std::cerr << "Failed to load texture from ../assets/container.jpg" << std::endl;
+        std::cerr << "Failed to load texture from container.jpg" << std::endl;
 
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
     glGenerateMipmap(GL_TEXTURE_2D);
@@ -112,9 +115,9 @@ int main()
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
     stbi_set_flip_vertically_on_load(true);
-    data = stbi_load("../assets/awesomeface.png", &width, &height, &nr_channels, 0);
+    data = decode_image_file("awesomeface.png", width, height, nr_channels);
     if (!data)
-        std::cerr << "Failed to load texture from ../assets/awesomeface.png" << std::endl;
+        std::cerr << "Failed to load texture from awesomeface.png" << std::endl;
 
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
     glGenerateMipmap(GL_TEXTURE_2D);
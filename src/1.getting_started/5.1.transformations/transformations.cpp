@@ -19,6 +19,11 @@
 #include "shader.h"
 #include "stb_image.h"
 #include "utility.h"
+#include "instance_buffer.h"
+#include "stream_buffer.h"
+#include "gl_state_cache.h"
+#include "texture_container.h"
+#include "virtual_file_system.h"
 
 struct VertexData {
   unsigned int VAO = 0;
@@ -103,15 +108,15 @@ void update_difficulty(GameState &g, Difficulty d) {
 //  std::cout << "Updating difficulty to " << static_cast<int>(d) << std::endl;
   g.difficulty = d;
   switch (d) {
-  case Difficulty::LOW:g.song = "../assets/Greenberg.mp3";
+  case Difficulty::LOW:g.song = "Greenberg.mp3";
     g.grid_size = GridSize::SMALL;
     g.tick_time = 0.5;
     break;
-  case Difficulty::MEDIUM:g.song = "../assets/Drivin.mp3";
+  case Difficulty::MEDIUM:g.song = "Drivin.mp3";
     g.grid_size = GridSize::MEDIUM;
     g.tick_time = 0.125;
     break;
-  case Difficulty::HIGH:g.song = "../assets/Eastward.mp3";
+  case Difficulty::HIGH:g.song = "Eastward.mp3";
     g.grid_size = GridSize::BIG;
     g.tick_time = 0.05;
     break;
@@ -223,10 +228,15 @@ Point spawn_meal(int grid_size, const std::deque<Point> &snake_parts) {
   return {x, y};
 }
 
+// two lines of two 2d points for each of the grid_size + 1 rows and columns
+size_t get_grid_float_count(unsigned int grid_size) {
+  return (grid_size + 1) * 2 * 2 * 2;
+}
+
 std::vector<float> generate_grid(unsigned int max_grid_size) {
   const float offset = max_grid_size / 2.0f;
   std::vector<float> vertices;
-  vertices.reserve(max_grid_size * 4 * 2);
+  vertices.reserve(get_grid_float_count(max_grid_size));
 
   for (int i = 0; i <= max_grid_size; ++i) {
     vertices.push_back(-offset);
@@ -255,7 +265,10 @@ VertexData init_grid_vertices() {
 
   glGenBuffers(1, &vertex_data.VBO);
   glBindBuffer(GL_ARRAY_BUFFER, vertex_data.VBO);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(float) * vertex_data.vertices.size(), &vertex_data.vertices[0], GL_DYNAMIC_DRAW);
+  // sized for the biggest grid once, draw_grid only rewrites the vertices when the size changes
+  const size_t capacity = get_grid_float_count(static_cast<int>(GridSize::BIG));
+  glBufferData(GL_ARRAY_BUFFER, sizeof(float) * capacity, nullptr, GL_DYNAMIC_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(float) * vertex_data.vertices.size(), &vertex_data.vertices[0]);
 
   glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), nullptr);
   glEnableVertexAttribArray(0);
@@ -270,10 +283,8 @@ void draw_grid(Shader &shader, VertexData &vertex_data, bool update_grid, unsign
 
   if (update_grid) {
     vertex_data.vertices = generate_grid(static_cast<int>(grid_size));
-    glBufferData(GL_ARRAY_BUFFER,
-                 sizeof(double) * vertex_data.vertices.size(),
-                 &vertex_data.vertices[0],
-                 GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_data.VBO);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(float) * vertex_data.vertices.size(), &vertex_data.vertices[0]);
   }
 
   glDrawArrays(GL_LINES, 0, vertex_data.vertices.size() / 2);
@@ -289,20 +300,23 @@ void print_snake_pos(const std::deque<Point> &snake, const Point &meal) {
 void draw_snake(const std::deque<Point> &parts,
                 const Shader &shader,
                 const VertexData &vertex_data,
-                const GameState &game) {
-  shader.use();
-  for (auto p: parts) {
-    glm::mat4 model(1.0f);
-    model = glm::translate(model, glm::vec3(p.x - 0.5f, p.y - 0.5f, 0.0f));
-//    model = glm::scale(model, glm::vec3(0.99f));
-    shader.set_mat4("model", model);
-    shader.set_vec4("in_color", glm::vec4(1.0f, 0.0f, 0.0f, 1.0f));
-    shader.set_float("in_rotation", glm::radians(game.texture_angle));
-    glBindTexture(GL_TEXTURE_2D, vertex_data.texture);
-    glBindVertexArray(vertex_data.VAO);
-    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
-  }
+                const GameState &game,
+                InstanceBuffer &instances,
+                StreamBuffer &stream) {
+  std::vector<glm::mat4> models;
+  models.reserve(parts.size());
+  for (auto p: parts)
+    models.push_back(glm::translate(glm::mat4(1.0f), glm::vec3(p.x - 0.5f, p.y - 0.5f, 0.0f)));
+
+  // the rest of this file binds with raw gl calls, so the cache used by InstanceBuffer may be stale
+  GLStateCache::get().invalidate();
+  instances.set_instances(stream, models);
 
+  shader.use();
+  shader.set_vec4("in_color", glm::vec4(1.0f, 0.0f, 0.0f, 1.0f));
+  shader.set_float("in_rotation", glm::radians(game.texture_angle));
+  glBindTexture(GL_TEXTURE_2D, vertex_data.texture);
+  instances.draw_elements(vertex_data.VAO, GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
 }
 
 void draw_meal(const Shader &shader, const VertexData &vertex_data, const Point &meal) {
@@ -326,7 +340,7 @@ void init_game_state(GameState &state) {
   state.difficulty = state.prev_difficulty = Difficulty::LOW;
   state.direction = state.prev_direction = Direction::NONE;
   state.grid_size = GridSize::SMALL;
-  state.song = "../assets/Greenberg.mp3";
+  state.song = "Greenberg.mp3";
   state.tick_time = 0.5;
   state.velocity = {0, 0};
   state.snake_parts = std::deque<Point>(1, {1, 1});
@@ -346,17 +360,25 @@ int main() {
   GLFWwindow *window = init_glfw();
   if (!window)
     return -1;
+  VirtualFileSystem::get().mount_assets();
 
   Shader shader("5.1.shader.vs", "5.1.shader.fs");
+  Shader snake_shader("5.1.snake_shader.vs", "5.1.shader.fs");
   Shader grid_shader("5.1.line_shader.vs", "5.1.line_shader.fs");
   VertexData vertex_data = init_vertices();
   VertexData line_vertex_data = init_grid_vertices();
+  // segments are rewritten every frame, the biggest grid holds 32 * 32 of them
+  constexpr size_t MAX_SEGMENTS = static_cast<int>(GridSize::BIG) * static_cast<int>(GridSize::BIG);
+  InstanceBuffer snake_instances(1);
+  StreamBuffer frame_stream(MAX_SEGMENTS * (sizeof(glm::mat4) + sizeof(glm::vec4)));
 
   GameState game;
   init_game_state(game);
 
   while (!glfwWindowShouldClose(window)) {
+    frame_stream.begin_frame();
     setup_uniforms(shader, game);
+    setup_uniforms(snake_shader, game);
     setup_uniforms(grid_shader, game);
     process_input(window, game);
     game.end_time = glfwGetTime();
@@ -377,11 +399,12 @@ int main() {
     glClear(GL_COLOR_BUFFER_BIT);
 
     draw_grid(grid_shader, line_vertex_data, should_update_grid(game), static_cast<int>(game.grid_size));
-    draw_snake(game.snake_parts, shader, vertex_data, game);
+    draw_snake(game.snake_parts, snake_shader, vertex_data, game, snake_instances, frame_stream);
     if (!game.ate_meal)
       draw_meal(shader, vertex_data, game.meal);
 
     //debug_draw(shader, vertex_data, game);
+    frame_stream.end_frame();
 
     glfwSwapBuffers(window);
     glfwPollEvents();
@@ -486,9 +509,9 @@ VertexData init_vertices() {
   int32_t width;
   int32_t height;
   int32_t nr_channels;
-  unsigned char *data = stbi_load("../assets/ant.png", &width, &height, &nr_channels, 0);
+  unsigned char *data = decode_image_file("ant.png", width, height, nr_channels);
   if (!data)
-    std::cerr << "Failed to load texture from ../assets/ant.png" << std::endl;
+    std::cerr << "Failed to load texture from ant.png" << std::endl;
 
   glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
   glGenerateMipmap(GL_TEXTURE_2D);
@@ -554,7 +577,8 @@ void play_audio(GameState &game) {
   }
 
   ma_result result;
-  result = ma_decoder_init_file(game.song.c_str(), NULL, &game.decoder);
+  // miniaudio streams from the file, it has to be a loose one
+  result = ma_decoder_init_file(VirtualFileSystem::get().resolve(game.song).c_str(), NULL, &game.decoder);
   if (result != MA_SUCCESS) {
     return;
   }
@@ -164,9 +164,9 @@ int main()
     };
 
     Material m = chrome;
-    Texture diffuse_map("assets/container2.png");
-    Texture specular_map("assets/container2_specular.png");
-    Texture emission_map("assets/matrix.jpg");
+    Texture diffuse_map("container2.png");
+    Texture specular_map("container2_specular.png");
+    Texture emission_map("matrix.jpg");
 
     while (!glfwWindowShouldClose(window)) {
         end = glfwGetTime();
@@ -210,12 +210,9 @@ int main()
         object_shader.set_vec3("u_light.diffuse", light.diffuse);
         object_shader.set_vec3("u_light.specular", light.specular);
         object_va.bind();
-        GL_CALL(glActiveTexture(GL_TEXTURE0));
-        diffuse_map.bind();
-        GL_CALL(glActiveTexture(GL_TEXTURE1));
-        specular_map.bind();
-        GL_CALL(glActiveTexture(GL_TEXTURE2));
-        emission_map.bind();
+        diffuse_map.bind(0);
+        specular_map.bind(1);
+        emission_map.bind(2);
         GL_CALL(glDrawArrays(GL_TRIANGLES, 0, 36));
 
         lighting_shader.use();
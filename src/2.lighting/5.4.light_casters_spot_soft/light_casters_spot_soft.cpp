@@ -191,8 +191,8 @@ int main()
 	};
 
 	Material m = bronze;
-	Texture diffuse_map("../../assets/container2.png");
-	Texture specular_map("../../assets/container2_specular.png");
+	Texture diffuse_map("container2.png");
+	Texture specular_map("container2_specular.png");
 
 	while (!glfwWindowShouldClose(window)) {
 		end = glfwGetTime();
@@ -238,10 +238,8 @@ int main()
 		object_shader.set_float("u_light.linear", 0.09f);
 		object_shader.set_float("u_light.quadratic", 0.032f);
 		object_va.bind();
-		GL_CALL(glActiveTexture(GL_TEXTURE0));
-		diffuse_map.bind();
-		GL_CALL(glActiveTexture(GL_TEXTURE1));
-		specular_map.bind();
+		diffuse_map.bind(0);
+		specular_map.bind(1);
 		for (const auto& cube_world_position : cube_world_positions)
 		{
 			object_shader.set_mat4("model", cube_world_position);
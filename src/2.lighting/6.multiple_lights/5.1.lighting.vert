@@ -2,9 +2,14 @@
 
 layout(location = 0) in vec4 in_position;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// per instance, see instance_buffer.h
+layout (location = 8) in mat4 model;
+
+layout (std140) uniform CameraBlock {
+	mat4 view;
+	mat4 projection;
+	vec3 view_pos;
+};
 
 void main()
 {
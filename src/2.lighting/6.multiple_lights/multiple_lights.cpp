@@ -3,6 +3,7 @@
 //
 
 #include <iostream>
+#include <utility>
 #include <vector>
 
 #include <glad/glad.h>
@@ -16,7 +17,12 @@
 #include "vertex_array.h"
 #include "vertex_buffer.h"
 #include "vertex_buffer_layout.h"
+#include "instance_buffer.h"
 #include "texture.h"
+#include "cpu_timer.h"
+#include "uniform_buffer.h"
+#include "uniform_blocks.h"
+#include "uniform_name.h"
 
 void process_input(GLFWwindow* window, Camera& camera, double delta_time)
 {
@@ -49,6 +55,136 @@ struct Material {
 	float shininess;
 };
 
+constexpr unsigned int NUM_PONT_LIGHTS = 4;
+static_assert(NUM_PONT_LIGHTS <= MAX_POINT_LIGHTS);
+
+// handles of object_uniforms.frag, which takes the blocks' fields as plain uniforms
+struct PointLightUniforms {
+	UniformHandle constant;
+	UniformHandle linear;
+	UniformHandle quadratic;
+	UniformHandle position;
+	UniformHandle ambient;
+	UniformHandle diffuse;
+	UniformHandle specular;
+};
+
+struct ObjectUniforms {
+	UniformHandle view;
+	UniformHandle projection;
+	UniformHandle view_pos;
+	UniformHandle material_diffuse;
+	UniformHandle material_specular;
+	UniformHandle material_shininess;
+	UniformHandle dir_light_direction;
+	UniformHandle dir_light_ambient;
+	UniformHandle dir_light_diffuse;
+	UniformHandle dir_light_specular;
+	UniformHandle spot_light_position;
+	UniformHandle spot_light_direction;
+	UniformHandle spot_light_outer_cut_off;
+	UniformHandle spot_light_cut_off;
+	UniformHandle spot_light_ambient;
+	UniformHandle spot_light_diffuse;
+	UniformHandle spot_light_specular;
+	UniformHandle spot_light_constant;
+	UniformHandle spot_light_linear;
+	UniformHandle spot_light_quadratic;
+	PointLightUniforms point_lights[NUM_PONT_LIGHTS];
+};
+
+template <typename Name, typename Resolve>
+UniformHandle resolve_indexed_uniform(Resolve resolve)
+{
+	return resolve(Name::c_str(), Name::hash);
+}
+
+// names and hashes are built at compile time, so resolving them allocates and hashes nothing
+template <std::size_t Index, typename Resolve>
+PointLightUniforms resolve_point_light_uniforms(Resolve resolve)
+{
+	PointLightUniforms u;
+	u.constant = resolve_indexed_uniform<IndexedUniformName<"point_lights", Index, "constant">>(resolve);
+	u.linear = resolve_indexed_uniform<IndexedUniformName<"point_lights", Index, "linear">>(resolve);
+	u.quadratic = resolve_indexed_uniform<IndexedUniformName<"point_lights", Index, "quadratic">>(resolve);
+	u.position = resolve_indexed_uniform<IndexedUniformName<"point_lights", Index, "position">>(resolve);
+	u.ambient = resolve_indexed_uniform<IndexedUniformName<"point_lights", Index, "ambient">>(resolve);
+	u.diffuse = resolve_indexed_uniform<IndexedUniformName<"point_lights", Index, "diffuse">>(resolve);
+	u.specular = resolve_indexed_uniform<IndexedUniformName<"point_lights", Index, "specular">>(resolve);
+	return u;
+}
+
+// resolve is called with each uniform's name and its hash_uniform_name
+template <typename Resolve>
+ObjectUniforms resolve_object_uniforms(Resolve resolve_hashed)
+{
+	const auto resolve = [&](const char* name) {
+		return resolve_hashed(name, hash_uniform_name(name));
+	};
+	ObjectUniforms u;
+	u.view = resolve("view");
+	u.projection = resolve("projection");
+	u.view_pos = resolve("view_pos");
+	u.material_diffuse = resolve("material.diffuse");
+	u.material_specular = resolve("material.specular");
+	u.material_shininess = resolve("material.shininess");
+	u.dir_light_direction = resolve("dir_light.direction");
+	u.dir_light_ambient = resolve("dir_light.ambient");
+	u.dir_light_diffuse = resolve("dir_light.diffuse");
+	u.dir_light_specular = resolve("dir_light.specular");
+	u.spot_light_position = resolve("spot_light.position");
+	u.spot_light_direction = resolve("spot_light.direction");
+	u.spot_light_outer_cut_off = resolve("spot_light.outer_cut_off");
+	u.spot_light_cut_off = resolve("spot_light.cut_off");
+	u.spot_light_ambient = resolve("spot_light.ambient");
+	u.spot_light_diffuse = resolve("spot_light.diffuse");
+	u.spot_light_specular = resolve("spot_light.specular");
+	u.spot_light_constant = resolve("spot_light.constant");
+	u.spot_light_linear = resolve("spot_light.linear");
+	u.spot_light_quadratic = resolve("spot_light.quadratic");
+	[&]<std::size_t... I>(std::index_sequence<I...>) {
+		((u.point_lights[I] = resolve_point_light_uniforms<I>(resolve_hashed)), ...);
+	}(std::make_index_sequence<NUM_PONT_LIGHTS>{});
+	return u;
+}
+
+// the uniform set the blocks replace, uploaded one glUniform* call at a time
+void set_object_uniforms(const Shader& shader, const ObjectUniforms& u, const CameraBlock& camera_block,
+	const LightsBlock& lights, float shininess)
+{
+	shader.set_mat4(u.view, camera_block.view);
+	shader.set_mat4(u.projection, camera_block.projection);
+	shader.set_vec3(u.view_pos, camera_block.view_pos);
+	shader.set_int(u.material_diffuse, 0);
+	shader.set_int(u.material_specular, 1);
+	shader.set_float(u.material_shininess, shininess);
+	shader.set_vec3(u.dir_light_direction, lights.dir_light.direction);
+	shader.set_vec3(u.dir_light_ambient, lights.dir_light.ambient);
+	shader.set_vec3(u.dir_light_diffuse, lights.dir_light.diffuse);
+	shader.set_vec3(u.dir_light_specular, lights.dir_light.specular);
+	shader.set_vec3(u.spot_light_position, lights.spot_light.position);
+	shader.set_vec3(u.spot_light_direction, lights.spot_light.direction);
+	shader.set_float(u.spot_light_outer_cut_off, lights.spot_light.outer_cut_off);
+	shader.set_float(u.spot_light_cut_off, lights.spot_light.cut_off);
+	shader.set_vec3(u.spot_light_ambient, lights.spot_light.ambient);
+	shader.set_vec3(u.spot_light_diffuse, lights.spot_light.diffuse);
+	shader.set_vec3(u.spot_light_specular, lights.spot_light.specular);
+	shader.set_float(u.spot_light_constant, lights.spot_light.constant);
+	shader.set_float(u.spot_light_linear, lights.spot_light.linear);
+	shader.set_float(u.spot_light_quadratic, lights.spot_light.quadratic);
+	for (unsigned int i = 0; i < NUM_PONT_LIGHTS; ++i) {
+		const PointLightUniforms& pl = u.point_lights[i];
+		const PointLightStd140& light = lights.point_lights[i];
+		shader.set_float(pl.constant, light.constant);
+		shader.set_float(pl.linear, light.linear);
+		shader.set_float(pl.quadratic, light.quadratic);
+		shader.set_vec3(pl.position, light.position);
+		shader.set_vec3(pl.ambient, light.ambient);
+		shader.set_vec3(pl.diffuse, light.diffuse);
+		shader.set_vec3(pl.specular, light.specular);
+	}
+}
+
 int main()
 {
 	constexpr int win_width = 800;
@@ -81,6 +217,7 @@ int main()
 
 	Shader lighting_shader("5.1.lighting.vert", "5.1.lighting.frag");
 	Shader object_shader("object.vert", "object.frag");
+	Shader uniform_object_shader("object_uniforms.vert", "object_uniforms.frag");
 
 	const std::vector<float> vertices = {
 		// positions          // normals           // texture coords
@@ -141,7 +278,6 @@ int main()
 		{-1.3f,  1.0f, -1.5f}
 	};
 
-	constexpr unsigned int NUM_PONT_LIGHTS = 4;
 	constexpr glm::vec3 point_lights_positions[NUM_PONT_LIGHTS] = {
 		{0.7f,  0.2f,  2.0f},
 		{2.3f, -3.3f, -4.0f},
@@ -198,8 +334,77 @@ int main()
 	};
 
 	Material m = chrome;
-	Texture diffuse_map("../../assets/container2.png");
-	Texture specular_map("../../assets/container2_specular.png");
+	Texture diffuse_map("container2.png");
+	Texture specular_map("container2_specular.png");
+
+	object_shader.set_uniform_block_binding("CameraBlock", CAMERA_BLOCK_BINDING);
+	object_shader.set_uniform_block_binding("LightsBlock", LIGHTS_BLOCK_BINDING);
+	object_shader.set_uniform_block_binding("MaterialBlock", MATERIAL_BLOCK_BINDING);
+	lighting_shader.set_uniform_block_binding("CameraBlock", CAMERA_BLOCK_BINDING);
+
+	UniformBuffer camera_ubo(sizeof(CameraBlock), CAMERA_BLOCK_BINDING);
+	UniformBuffer lights_ubo(sizeof(LightsBlock), LIGHTS_BLOCK_BINDING);
+	UniformBuffer material_ubo(sizeof(MaterialBlock), MATERIAL_BLOCK_BINDING);
+
+	// material does not change between frames, upload it once
+	material_ubo.set_data(MaterialBlock{m.shininess});
+
+	LightsBlock lights{};
+	lights.dir_light.direction = {-0.2f, -1.0f, -0.3f};
+	lights.dir_light.ambient = glm::vec3(0.0f);
+	lights.dir_light.diffuse = glm::vec3(0.0f);
+	lights.dir_light.specular = glm::vec3(0.0f);
+	for (unsigned int i = 0; i < NUM_PONT_LIGHTS; ++i) {
+		PointLightStd140& pl = lights.point_lights[i];
+		pl.constant = 0.1f;
+		pl.linear = 0.09f;
+		pl.quadratic = 0.032f;
+		pl.position = point_lights_positions[i];
+		pl.ambient = light.ambient * glm::vec3(0.3f);
+		pl.diffuse = light.diffuse * glm::vec3(0.4f);
+		pl.specular = light.specular * glm::vec3(1.0f);
+	}
+	lights.spot_light.outer_cut_off = glm::cos(glm::radians(12.5f));
+	lights.spot_light.cut_off = glm::cos(glm::radians(17.5f));
+	lights.spot_light.ambient = glm::vec3(0.1f);
+	lights.spot_light.diffuse = glm::vec3(0.8f);
+	lights.spot_light.specular = glm::vec3(1.0f);
+	lights.spot_light.constant = 1.0f;
+	lights.spot_light.linear = 0.09f;
+	lights.spot_light.quadratic = 0.032f;
+	lights.num_point_lights = NUM_PONT_LIGHTS;
+
+	// transforms never change, each set of cubes is one instanced draw
+	InstanceBuffer cube_instances(MAX_POSITIONS);
+	cube_instances.set_instances(cube_world_positions);
+	glm::mat4 light_world_positions[NUM_PONT_LIGHTS];
+	for (unsigned int i = 0; i < NUM_PONT_LIGHTS; ++i) {
+		light_world_positions[i] = glm::translate(glm::mat4(1.0f), point_lights_positions[i]);
+		light_world_positions[i] = glm::scale(light_world_positions[i], glm::vec3(0.2f));
+	}
+	InstanceBuffer light_instances(NUM_PONT_LIGHTS);
+	light_instances.set_instances(light_world_positions);
+	object_shader.use();
+	object_shader.set_int("material.diffuse", 0);
+	object_shader.set_int("material.specular", 1);
+
+	// press U to switch to setting every field as a plain uniform, the way the blocks replaced
+	const ObjectUniforms object_uniforms = resolve_object_uniforms([&](const char*, UniformHash hash) {
+		return uniform_object_shader.get_uniform(hash);
+	});
+	// then press B to compare the cached handles against glGetUniformLocation for every uniform each frame
+	const auto resolve_by_driver = [&](const char* name, UniformHash) {
+		return UniformHandle{glGetUniformLocation(uniform_object_shader.get_program(), name)};
+	};
+	bool use_uniform_blocks = true;
+	bool blocks_toggle_pressed = false;
+	bool resolve_every_frame = false;
+	bool resolve_toggle_pressed = false;
+	CpuTimer block_timer("uniforms (uniform blocks)");
+	CpuTimer handle_timer("uniforms (cached handles)");
+	CpuTimer driver_timer("uniforms (glGetUniformLocation)");
+	// compare builds configured with -DGL_CALL_CHECKS=ON and OFF
+	CpuTimer frame_timer("frame cpu, GL_CALL_CHECKS=" + std::to_string(GL_CALL_CHECKS));
 
 	while (!glfwWindowShouldClose(window)) {
 		end = glfwGetTime();
@@ -208,63 +413,50 @@ int main()
 		process_input(window, camera, time_span);
 		angle += static_cast<float>(time_span);
 
+		frame_timer.begin();
 		GL_CALL(glClearColor(0.0f, 0.0f, 0.0f, 1.0f));
 		GL_CALL(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
 
-		object_shader.use();
-		object_shader.set_mat4("view", camera.get_view());
-		object_shader.set_mat4("projection", projection);
-		object_shader.set_vec3("view_pos", camera.get_position());
-		object_shader.set_int("material.diffuse", 0);
-		object_shader.set_int("material.specular", 1);
-		object_shader.set_float("material.shininess", m.shininess);
-		object_shader.set_vec3("dir_light.direction", {-0.2f, -1.0f, -0.3f});
-		object_shader.set_vec3("dir_light.ambient", glm::vec3(0.0f));
-		object_shader.set_vec3("dir_light.diffuse", glm::vec3(0.0f));
-		object_shader.set_vec3("dir_light.specular", glm::vec3(0.0f));
-		object_shader.set_vec3("spot_light.position", camera.get_position());
-		object_shader.set_vec3("spot_light.direction", camera.get_front());
-		object_shader.set_float("spot_light.outer_cut_off", glm::cos(glm::radians(12.5f)));
-		object_shader.set_float("spot_light.cut_off", glm::cos(glm::radians(17.5f)));
-		object_shader.set_vec3("spot_light.ambient", glm::vec3(0.1f));
-		object_shader.set_vec3("spot_light.diffuse", glm::vec3(0.8f));
-		object_shader.set_vec3("spot_light.specular", glm::vec3(1.0f));
-		object_shader.set_float("spot_light.constant", 1.0f);
-		object_shader.set_float("spot_light.linear", 0.09f);
-		object_shader.set_float("spot_light.quadratic", 0.032f);
-		for (unsigned int i = 0; i < NUM_PONT_LIGHTS; ++i) {
-			object_shader.set_float(format("point_lights[{}].constant", i), 0.1f);
-			object_shader.set_float(format("point_lights[{}].linear", i), 0.09f);
-			object_shader.set_float(format("point_lights[{}].quadratic", i), 0.032f);
-			object_shader.set_vec3(format("point_lights[{}].position", i), point_lights_positions[i]);
-			object_shader.set_vec3(format("point_lights[{}].ambient", i), light.ambient * glm::vec3(0.3f));
-			object_shader.set_vec3(format("point_lights[{}].diffuse", i), light.diffuse * glm::vec3(0.4f));
-			object_shader.set_vec3(format("point_lights[{}].specular", i), light.specular * glm::vec3(1.0f));
-		}
-		object_va.bind();
-		GL_CALL(glActiveTexture(GL_TEXTURE0));
-		diffuse_map.bind();
-		GL_CALL(glActiveTexture(GL_TEXTURE1));
-		specular_map.bind();
-		for (const auto& cube_world_position : cube_world_positions) {
-			object_shader.set_mat4("model", cube_world_position);
-			GL_CALL(glDrawArrays(GL_TRIANGLES, 0, 36));
-		}
+		const bool blocks_toggle_down = glfwGetKey(window, GLFW_KEY_U) == GLFW_PRESS;
+		if (blocks_toggle_down && !blocks_toggle_pressed)
+			use_uniform_blocks = !use_uniform_blocks;
+		blocks_toggle_pressed = blocks_toggle_down;
+		const bool resolve_toggle_down = glfwGetKey(window, GLFW_KEY_B) == GLFW_PRESS;
+		if (resolve_toggle_down && !resolve_toggle_pressed)
+			resolve_every_frame = !resolve_every_frame;
+		resolve_toggle_pressed = resolve_toggle_down;
+
+		CpuTimer& timer = use_uniform_blocks ? block_timer : resolve_every_frame ? driver_timer : handle_timer;
+		timer.begin();
+		CameraBlock camera_block;
+		camera_block.view = camera.get_view();
+		camera_block.projection = projection;
+		camera_block.view_pos = camera.get_position();
+		// the light cubes read the camera block either way
+		camera_ubo.set_data(camera_block);
+
+		lights.spot_light.position = camera.get_position();
+		lights.spot_light.direction = camera.get_front();
+		const Shader& cube_shader = use_uniform_blocks ? object_shader : uniform_object_shader;
+		cube_shader.use();
+		if (use_uniform_blocks)
+			lights_ubo.set_data(lights);
+		else if (resolve_every_frame)
+			set_object_uniforms(uniform_object_shader, resolve_object_uniforms(resolve_by_driver), camera_block, lights, m.shininess);
+		else
+			set_object_uniforms(uniform_object_shader, object_uniforms, camera_block, lights, m.shininess);
+		timer.end();
+
+		diffuse_map.bind(0);
+		specular_map.bind(1);
+		cube_instances.draw_arrays(object_va.get_renderer_id(), GL_TRIANGLES, 0, 36);
 
 		lighting_shader.use();
-		lighting_shader.set_mat4("view", camera.get_view());
-		lighting_shader.set_mat4("projection", projection);
-		for (unsigned int i = 0; const auto &point_lights_position : point_lights_positions) {
-			glm::mat4 light_model(1.0f);
-			light_model = glm::translate(light_model, point_lights_position);
-			light_model = glm::scale(light_model, glm::vec3(0.2f));
-			lighting_shader.set_mat4("model", light_model);
-			lighting_shader.set_vec3("u_light.ambient", light.ambient);
-			lighting_shader.set_vec3("u_light.diffuse", light.diffuse);
-			lighting_shader.set_vec3("u_light.specular", light.specular);
-			GL_CALL(glDrawArrays(GL_TRIANGLES, 0, 36));
-		}
-		
+		lighting_shader.set_vec3("u_light.ambient", light.ambient);
+		lighting_shader.set_vec3("u_light.diffuse", light.diffuse);
+		lighting_shader.set_vec3("u_light.specular", light.specular);
+		light_instances.draw_arrays(object_va.get_renderer_id(), GL_TRIANGLES, 0, 36);
+		frame_timer.end();
 
 		glfwSwapBuffers(window);
 		glfwPollEvents();
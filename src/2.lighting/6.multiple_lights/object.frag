@@ -1,5 +1,8 @@
 #version 330 core
 
+#define NR_POINT_LIGHTS 4
+
+// member order follows the std140 mirrors in uniform_blocks.h
 struct DirLight {
 	vec3 direction;
 	vec3 ambient;
@@ -10,30 +13,29 @@ struct DirLight {
 struct PointLight {
 	vec3 position;
 	float constant;
-	float linear;
-	float quadratic;
 	vec3 ambient;
+	float linear;
 	vec3 diffuse;
+	float quadratic;
 	vec3 specular;
 };
 
 struct SpotLight {
 	vec3 position;
-	vec3 direction;
 	float cut_off;
+	vec3 direction;
 	float outer_cut_off;
 	vec3 ambient;
-	vec3 diffuse;
-	vec3 specular;
 	float constant;
+	vec3 diffuse;
 	float linear;
+	vec3 specular;
 	float quadratic;
 };
 
 struct Material {
     sampler2D diffuse;
     sampler2D specular;
-    float shininess;
 };
 
 in vec3 normal;
@@ -42,13 +44,24 @@ in vec2 text_coords;
 
 out vec4 frag_color;
 
-#define NR_POINT_LIGHTS 4
+layout (std140) uniform CameraBlock {
+	mat4 view;
+	mat4 projection;
+	vec3 view_pos;
+};
+
+layout (std140) uniform LightsBlock {
+	DirLight dir_light;
+	PointLight point_lights[NR_POINT_LIGHTS];
+	SpotLight spot_light;
+	int num_point_lights;
+};
+
+layout (std140) uniform MaterialBlock {
+	float shininess;
+};
 
-uniform DirLight dir_light;
-uniform PointLight[NR_POINT_LIGHTS] point_lights;
 uniform Material material;
-uniform vec3 view_pos;
-uniform SpotLight spot_light;
 
 vec3 CalcDirLight(DirLight light, vec3 normal, vec3 view_dir);
 vec3 CalcPointLight(PointLight light, vec3 normal, vec3 frag_pos, vec3 view_dir);
@@ -61,7 +74,7 @@ void main()
 	// phase 1: Directional lighting
 	vec3 result = CalcDirLight(dir_light, norm, view_dir);
 	// phase 2: Point lights
-	for (int i = 0; i < NR_POINT_LIGHTS; ++i)
+	for (int i = 0; i < num_point_lights; ++i)
 		result += CalcPointLight(point_lights[i], norm, frag_pos, view_dir);
 	// phase 3: Spot light
 	result += CalcSpotLight(spot_light, norm, frag_pos, view_dir);
@@ -76,7 +89,7 @@ vec3 CalcDirLight(DirLight light, vec3 normal, vec3 view_dir)
 	float diff = max(dot(light_dir, normal), 0.0);
 	// specular shading
 	vec3 reflect_dir = reflect(-light_dir, normal);
-	float spec = pow(max(dot(view_dir, reflect_dir), 0.0), material.shininess);
+	float spec = pow(max(dot(view_dir, reflect_dir), 0.0), shininess);
 	// combine results
 	vec3 ambient = light.ambient * vec3(texture(material.diffuse, text_coords));
 	vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, text_coords));
@@ -92,7 +105,7 @@ vec3 CalcPointLight(PointLight light, vec3 normal, vec3 frag_pos, vec3 view_dir)
 	float diff = max(dot(light_dir, normal), 0.0);
 	// specular shading
 	vec3 reflect_dir = reflect(-light_dir, normal);
-	float spec = pow(max(dot(view_dir, reflect_dir), 0.0), material.shininess);
+	float spec = pow(max(dot(view_dir, reflect_dir), 0.0), shininess);
 	// attenuation
 	float distance = length(light.position - frag_pos);
 	float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
@@ -119,7 +132,7 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 frag_pos, vec3 view_dir)
 
 	// specular shading
 	vec3 reflect_dir = reflect(-light_dir, norm);
-	float spec = pow(max(dot(view_dir, reflect_dir), 0.0), material.shininess);
+	float spec = pow(max(dot(view_dir, reflect_dir), 0.0), shininess);
 	vec3 specular = light.specular * spec * vec3(texture(material.specular, text_coords));
 
 	// spotlight soft edges
@@ -8,9 +8,14 @@ out vec3 normal;
 out vec3 frag_pos;
 out vec2 text_coords;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// per instance, see instance_buffer.h
+layout (location = 8) in mat4 model;
+
+layout (std140) uniform CameraBlock {
+	mat4 view;
+	mat4 projection;
+	vec3 view_pos;
+};
 
 void main()
 {
@@ -2,6 +2,7 @@
 // Created by vocasle on 11/24/21.
 //
 
+#include <chrono>
 #include <iostream>
 #include <vector>
 
@@ -15,6 +16,10 @@
 #include "shader.h"
 #include "utility.h"
 #include "model.h"
+#include "async_texture_loader.h"
+#include "uniform_buffer.h"
+#include "uniform_blocks.h"
+#include "gl_state_cache.h"
 
 void process_input(GLFWwindow *window, Camera &camera, double delta_time) {
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
@@ -43,7 +48,11 @@ int main() {
     }
     stbi_set_flip_vertically_on_load(true);
     gl_print_debug_info();
-    gl_enable_debug_output();
+#if GL_CALL_CHECKS == 2
+    // NVIDIA reports where every buffer object lives each time one is (re)allocated
+    constexpr GLuint NVIDIA_BUFFER_INFO_MESSAGE = 131185;
+    gl_ignore_debug_message(GL_DEBUG_SOURCE_API, GL_DEBUG_TYPE_OTHER, NVIDIA_BUFFER_INFO_MESSAGE);
+#endif
 
     const glm::vec3 camera_pos = glm::vec3(0.0f, 0.0f, 3.0f);
     Camera camera(1.0f, camera_pos);
@@ -79,7 +88,68 @@ int main() {
     float angle = 1.0f;
 
 
-    Model backpack_model("../../assets/backpack.obj");
+    // run twice to compare a cold load (no cache yet) with a warm one,
+    // textures keep decoding in the background after the model is returned
+    constexpr double TEXTURE_UPLOAD_BUDGET_MS = 2.0;
+    AsyncTextureLoader texture_loader;
+    const auto load_begin = std::chrono::steady_clock::now();
+    ModelOptions model_options;
+    model_options.textureLoader = &texture_loader;
+    model_options.optimizeMeshes = true;
+    model_options.upload.format = VertexFormat::CompactQuantized;
+    model_options.upload.splitIndexRanges = true;
+    model_options.upload.sharedGeometry = true;
+    Model backpack_model("backpack/backpack.obj", model_options);
+    const std::chrono::duration<double, std::milli> load_time = std::chrono::steady_clock::now() - load_begin;
+    std::cout << "model load: " << load_time.count() << " ms ("
+              << (backpack_model.loadedFromCache ? "warm, mesh cache" : "cold, assimp") << ")" << std::endl;
+    size_t vertex_count = 0;
+    size_t vertex_bytes = 0;
+    size_t index_count = 0;
+    size_t index_bytes = 0;
+    for (const Mesh &mesh : backpack_model.meshes) {
+        vertex_count += mesh.vertexCount;
+        vertex_bytes += mesh.vertexBytes;
+        index_count += mesh.indexCount;
+        index_bytes += mesh.indexBytes;
+    }
+    std::cout << "vertex memory: " << vertex_bytes / 1024 << " KiB packed, "
+              << vertex_count * sizeof(Vertex) / 1024 << " KiB as full Vertex" << std::endl;
+    std::cout << "index memory: " << index_bytes / 1024 << " KiB, "
+              << index_count * sizeof(unsigned int) / 1024 << " KiB as 32 bit" << std::endl;
+
+    object_shader.set_uniform_block_binding("CameraBlock", CAMERA_BLOCK_BINDING);
+    object_shader.set_uniform_block_binding("LightsBlock", LIGHTS_BLOCK_BINDING);
+    UniformBuffer camera_ubo(sizeof(CameraBlock), CAMERA_BLOCK_BINDING);
+    UniformBuffer lights_ubo(sizeof(LightsBlock), LIGHTS_BLOCK_BINDING);
+
+    // lights are static in this demo, upload them once
+    LightsBlock lights{};
+    lights.dir_light.direction = {-0.2f, -1.0f, -0.3f};
+    lights.dir_light.ambient = {0.05f, 0.05f, 0.05f};
+    lights.dir_light.diffuse = {0.4f, 0.4f, 0.4f};
+    lights.dir_light.specular = {1.0f, 1.0f, 1.0f};
+    lights.point_lights[0].constant = 1.0f;
+    lights.point_lights[0].linear = 0.09f;
+    lights.point_lights[0].quadratic = 0.032f;
+    lights.point_lights[0].position = {0.7f,  0.2f,  2.0f};
+    lights.point_lights[0].ambient = {0.05f, 0.05f, 0.05f};
+    lights.point_lights[0].diffuse = {0.8f, 0.8f, 0.8f};
+    lights.point_lights[0].specular = {1.0f, 1.0f, 1.0f};
+    lights.num_point_lights = 1;
+    lights_ubo.set_data(lights);
+
+    const UniformHandle model_uniform = object_shader.get_uniform("model");
+
+    constexpr unsigned int STATS_INTERVAL = 500;
+    unsigned int frame_count = 0;
+    GLStateCache::get().reset_counters();
+
+#if GL_CALL_CHECKS == 2
+    // F2 silences the KHR_debug callback, e.g. while profiling
+    bool debug_output = true;
+    bool debug_key_down = false;
+#endif
 
     while (!glfwWindowShouldClose(window)) {
         end = glfwGetTime();
@@ -88,6 +158,16 @@ int main() {
         process_input(window, camera, time_span);
         angle += static_cast<float>(time_span);
 
+#if GL_CALL_CHECKS == 2
+        const bool debug_key_pressed = glfwGetKey(window, GLFW_KEY_F2) == GLFW_PRESS;
+        if (debug_key_pressed && !debug_key_down) {
+            debug_output = !debug_output;
+            gl_set_debug_output(debug_output);
+            std::cout << "debug output: " << (debug_output ? "on" : "off") << std::endl;
+        }
+        debug_key_down = debug_key_pressed;
+#endif
+
         if (container.win_height != win_height || container.win_width != win_width) {
             win_height = container.win_height;
             win_width = container.win_width;
@@ -95,30 +175,43 @@ int main() {
                                           100.0f);
         }
 
+        if (!texture_loader.is_idle()) {
+            texture_loader.upload_pending(TEXTURE_UPLOAD_BUDGET_MS);
+            if (texture_loader.is_idle()) {
+                const std::chrono::duration<double, std::milli> textures_time = std::chrono::steady_clock::now() - load_begin;
+                std::cout << "textures ready: " << textures_time.count() << " ms after load start" << std::endl;
+            }
+        }
+
         GL_CALL(glClearColor(0.0f, 0.0f, 0.0f, 1.0f));
         GL_CALL(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
 
+        CameraBlock camera_block;
+        camera_block.view = camera.get_view();
+        camera_block.projection = projection;
+        camera_block.view_pos = camera.get_position();
+        camera_ubo.set_data(camera_block);
+
         object_shader.use();
-        object_shader.set_mat4("view", camera.get_view());
-        object_shader.set_mat4("projection", projection);
         glm::mat4 model(1.0f);
         model = glm::translate(model, glm::vec3(0.0));
         model = glm::scale(model, glm::vec3(1.0f));
-        object_shader.set_mat4("model", model);
-        object_shader.set_vec3("view_pos", camera.get_position());
-        object_shader.set_vec3("dir_light.direction", {-0.2f, -1.0f, -0.3f});
-        object_shader.set_vec3("dir_light.ambient", {0.05f, 0.05f, 0.05f});
-        object_shader.set_vec3("dir_light.diffuse", {0.4f, 0.4f, 0.4f});
-        object_shader.set_vec3("dir_light.specular", {1.0f, 1.0f, 1.0f});
-        object_shader.set_float("point_light.constant", 1.0f);
-        object_shader.set_float("point_light.linear", 0.09f);
-        object_shader.set_float("point_light.quadratic", 0.032f);
-        object_shader.set_vec3("point_light.position", {0.7f,  0.2f,  2.0f});
-        object_shader.set_vec3("point_light.ambient", {0.05f, 0.05f, 0.05f});
-        object_shader.set_vec3("point_light.diffuse", {0.8f, 0.8f, 0.8f});
-        object_shader.set_vec3("point_light.specular", {1.0f, 1.0f, 1.0f});
-
-        backpack_model.Draw(object_shader);
+        object_shader.set_mat4(model_uniform, model);
+
+        {
+            // Model::Draw goes through the state cache, name it in debug messages
+            GL_CALL_SITE_SCOPE("Model::Draw");
+            backpack_model.Draw(object_shader);
+        }
+
+        if (++frame_count == STATS_INTERVAL) {
+            const GLStateCache::Counters& counters = GLStateCache::get().get_counters();
+            std::cout << "binds per frame: " << counters.issued / STATS_INTERVAL
+                      << " issued, " << counters.skipped / STATS_INTERVAL
+                      << " skipped (" << backpack_model.meshes.size() << " meshes)" << std::endl;
+            GLStateCache::get().reset_counters();
+            frame_count = 0;
+        }
 
 
         glfwSwapBuffers(window);
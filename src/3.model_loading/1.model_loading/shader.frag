@@ -1,5 +1,8 @@
 #version 330 core
 
+#define NR_POINT_LIGHTS 4
+
+// member order follows the std140 mirrors in uniform_blocks.h
 struct DirLight {
 	vec3 direction;
 	vec3 ambient;
@@ -10,11 +13,24 @@ struct DirLight {
 struct PointLight {
 	vec3 position;
 	float constant;
+	vec3 ambient;
 	float linear;
+	vec3 diffuse;
 	float quadratic;
+	vec3 specular;
+};
+
+struct SpotLight {
+	vec3 position;
+	float cut_off;
+	vec3 direction;
+	float outer_cut_off;
 	vec3 ambient;
+	float constant;
 	vec3 diffuse;
+	float linear;
 	vec3 specular;
+	float quadratic;
 };
 
 out vec4 frag_color;
@@ -25,9 +41,19 @@ in vec3 normal;
 
 uniform sampler2D texture_diffuse1;
 uniform sampler2D texture_specular1;
-uniform DirLight dir_light;
-uniform PointLight point_light;
-uniform vec3 view_pos;
+
+layout (std140) uniform CameraBlock {
+	mat4 view;
+	mat4 projection;
+	vec3 view_pos;
+};
+
+layout (std140) uniform LightsBlock {
+	DirLight dir_light;
+	PointLight point_lights[NR_POINT_LIGHTS];
+	SpotLight spot_light;
+	int num_point_lights;
+};
 
 vec3 CalcDirLight(DirLight light, vec3 normal, vec3 view_dir);
 vec3 CalcPointLight(PointLight light, vec3 normal, vec3 frag_pos, vec3 view_dir);
@@ -39,7 +65,8 @@ void main()
     // phase 1: Directional lighting
     vec3 result = CalcDirLight(dir_light, norm, view_dir);
     // phase 2: Point lights
-    result += CalcPointLight(point_light, norm, frag_pos, view_dir);
+    for (int i = 0; i < num_point_lights; ++i)
+        result += CalcPointLight(point_lights[i], norm, frag_pos, view_dir);
 
     frag_color = vec4(result, 1.0);
 }
@@ -1,21 +1,49 @@
 #version 330 core
 
-layout (location = 0) in vec3 in_pos;
-layout (location = 1) in vec3 in_normal;
+// compact vertex format, see vertex_packing.h
+layout (location = 0) in vec4 in_pos;
+layout (location = 1) in vec4 in_normal_tangent;
 layout (location = 2) in vec2 in_text_coords;
 
 out vec2 text_coords;
 out vec3 frag_pos;
 out vec3 normal;
+out vec3 tangent;
+out vec3 bitangent;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// positions are stored relative to the mesh bounds
+uniform vec3 position_offset;
+uniform vec3 position_scale;
+
+layout (std140) uniform CameraBlock {
+	mat4 view;
+	mat4 projection;
+	vec3 view_pos;
+};
+
+vec3 oct_decode(vec2 e)
+{
+	vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	if (v.z < 0.0) {
+		vec2 signs = vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+		v.xy = (1.0 - abs(v.yx)) * signs;
+	}
+	return normalize(v);
+}
 
 void main()
 {
+	vec3 pos = position_offset + in_pos.xyz * position_scale;
+	vec3 in_normal = oct_decode(in_normal_tangent.xy);
+	vec3 in_tangent = oct_decode(in_normal_tangent.zw);
+	float bitangent_sign = in_pos.w * 2.0 - 1.0;
+
+	mat3 normal_matrix = mat3(transpose(inverse(model)));
 	text_coords = in_text_coords;
-	frag_pos = vec3(model * vec4(in_pos, 1.0));
-	normal = mat3(transpose(inverse(model))) * in_normal;
-	gl_Position = projection * view * model * vec4(in_pos, 1.0);
+	frag_pos = vec3(model * vec4(pos, 1.0));
+	normal = normal_matrix * in_normal;
+	tangent = normal_matrix * in_tangent;
+	bitangent = cross(normal, tangent) * bitangent_sign;
+	gl_Position = projection * view * model * vec4(pos, 1.0);
 }
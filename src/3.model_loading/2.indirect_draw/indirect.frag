@@ -0,0 +1,112 @@
+#version 430 core
+
+#define NR_POINT_LIGHTS 4
+
+// member order follows the std140 mirrors in uniform_blocks.h
+struct DirLight {
+	vec3 direction;
+	vec3 ambient;
+	vec3 diffuse;
+	vec3 specular;
+};
+
+struct PointLight {
+	vec3 position;
+	float constant;
+	vec3 ambient;
+	float linear;
+	vec3 diffuse;
+	float quadratic;
+	vec3 specular;
+};
+
+struct SpotLight {
+	vec3 position;
+	float cut_off;
+	vec3 direction;
+	float outer_cut_off;
+	vec3 ambient;
+	float constant;
+	vec3 diffuse;
+	float linear;
+	vec3 specular;
+	float quadratic;
+};
+
+out vec4 frag_color;
+
+in vec2 text_coords;
+in vec3 frag_pos;
+in vec3 normal;
+flat in uint diffuse_layer;
+flat in uint specular_layer;
+
+// layer 0 is white for meshes without a texture of that kind
+uniform sampler2DArray material_diffuse;
+uniform sampler2DArray material_specular;
+
+layout (std140) uniform CameraBlock {
+	mat4 view;
+	mat4 projection;
+	vec3 view_pos;
+};
+
+layout (std140) uniform LightsBlock {
+	DirLight dir_light;
+	PointLight point_lights[NR_POINT_LIGHTS];
+	SpotLight spot_light;
+	int num_point_lights;
+};
+
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 view_dir);
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 frag_pos, vec3 view_dir);
+
+void main()
+{
+	vec3 norm = normalize(normal);
+    vec3 view_dir = normalize(view_pos - frag_pos);
+    // phase 1: Directional lighting
+    vec3 result = CalcDirLight(dir_light, norm, view_dir);
+    // phase 2: Point lights
+    for (int i = 0; i < num_point_lights; ++i)
+        result += CalcPointLight(point_lights[i], norm, frag_pos, view_dir);
+
+    frag_color = vec4(result, 1.0);
+}
+
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 view_dir)
+{
+	vec3 light_dir = normalize(-light.direction);
+	// diffuse shading
+	float diff = max(dot(light_dir, normal), 0.0);
+	// specular shading
+	vec3 reflect_dir = reflect(-light_dir, normal);
+	float spec = pow(max(dot(view_dir, reflect_dir), 0.0), 32.0);
+	// combine results
+	vec3 ambient = light.ambient * vec3(texture(material_diffuse, vec3(text_coords, diffuse_layer)));
+	vec3 diffuse = light.diffuse * diff * vec3(texture(material_diffuse, vec3(text_coords, diffuse_layer)));
+	vec3 specular = light.specular * spec * vec3(texture(material_specular, vec3(text_coords, specular_layer)));
+	return (ambient + diffuse + specular);
+}
+
+
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 frag_pos, vec3 view_dir)
+{
+	vec3 light_dir = normalize(light.position - frag_pos);
+	// diffuse shading
+	float diff = max(dot(light_dir, normal), 0.0);
+	// specular shading
+	vec3 reflect_dir = reflect(-light_dir, normal);
+	float spec = pow(max(dot(view_dir, reflect_dir), 0.0), 32.0f);
+	// attenuation
+	float distance = length(light.position - frag_pos);
+	float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+	// combine results
+	vec3 ambient = light.ambient * vec3(texture(material_diffuse, vec3(text_coords, diffuse_layer)));
+	vec3 diffuse = light.diffuse * diff * vec3(texture(material_diffuse, vec3(text_coords, diffuse_layer)));
+	vec3 specular = light.specular * spec * vec3(texture(material_specular, vec3(text_coords, specular_layer)));
+	ambient *= attenuation;
+	diffuse *= attenuation;
+	specular *= attenuation;
+	return (ambient + diffuse + specular);
+}
\ No newline at end of file
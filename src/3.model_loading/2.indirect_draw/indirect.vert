@@ -0,0 +1,66 @@
+#version 430 core
+
+// compact vertex format, see vertex_packing.h
+layout (location = 0) in vec4 in_pos;
+layout (location = 1) in vec4 in_normal_tangent;
+layout (location = 2) in vec2 in_text_coords;
+// baseInstance + gl_InstanceID, see GeometryArena::DRAW_ID_ATTRIBUTE
+layout (location = 7) in uint in_draw_id;
+
+// mirror of IndirectModelDraw::DrawData
+struct DrawData {
+	vec4 position_offset;
+	vec4 position_scale;
+	uint diffuse_layer;
+	uint specular_layer;
+	uint padding[2];
+};
+
+layout (std430, binding = 0) readonly buffer DrawBlock {
+	DrawData draws[];
+};
+
+layout (std430, binding = 1) readonly buffer InstanceBlock {
+	mat4 instances[];
+};
+
+uniform int instances_per_draw;
+
+layout (std140) uniform CameraBlock {
+	mat4 view;
+	mat4 projection;
+	vec3 view_pos;
+};
+
+out vec2 text_coords;
+out vec3 frag_pos;
+out vec3 normal;
+flat out uint diffuse_layer;
+flat out uint specular_layer;
+
+vec3 oct_decode(vec2 e)
+{
+	vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	if (v.z < 0.0) {
+		vec2 signs = vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+		v.xy = (1.0 - abs(v.yx)) * signs;
+	}
+	return normalize(v);
+}
+
+void main()
+{
+	uint draw_index = in_draw_id / uint(instances_per_draw);
+	uint instance_index = in_draw_id % uint(instances_per_draw);
+	DrawData draw = draws[draw_index];
+	mat4 model = instances[instance_index];
+
+	vec3 pos = draw.position_offset.xyz + in_pos.xyz * draw.position_scale.xyz;
+	diffuse_layer = draw.diffuse_layer;
+	specular_layer = draw.specular_layer;
+	text_coords = in_text_coords;
+	frag_pos = vec3(model * vec4(pos, 1.0));
+	// instances are only rotated, translated and uniformly scaled
+	normal = mat3(model) * oct_decode(in_normal_tangent.xy);
+	gl_Position = projection * view * vec4(frag_pos, 1.0);
+}
@@ -0,0 +1,184 @@
+//
+// Benchmark scene for IndirectModelDraw: a grid of backpacks drawn either
+// with Model::Draw per instance or with one multi draw indirect per frame.
+// Press I to switch between the two, the CPU time spent submitting the
+// draws of each path is printed every 500 frames.
+//
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <stb_image.h>
+
+#include "camera.h"
+#include "cpu_timer.h"
+#include "indirect_draw.h"
+#include "model.h"
+#include "shader.h"
+#include "uniform_blocks.h"
+#include "uniform_buffer.h"
+#include "utility.h"
+
+constexpr int GRID_WIDTH = 50;
+constexpr int GRID_DEPTH = 40;
+constexpr float GRID_SPACING = 4.0f;
+
+void process_input(GLFWwindow *window, Camera &camera, double delta_time) {
+    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, GLFW_TRUE);
+
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+        camera.update_pos(Direction::FORWARD, delta_time);
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+        camera.update_pos(Direction::BACKWARD, delta_time);
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+        camera.update_pos(Direction::LEFT, delta_time);
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+        camera.update_pos(Direction::RIGHT, delta_time);
+
+    camera.toggle_acceleration(glfwGetKey(window, GLFW_KEY_LEFT_CONTROL) == GLFW_PRESS);
+}
+
+int main() {
+    int win_width = 800;
+    int win_height = 600;
+
+    GLFWwindow *window = init_gl_context(win_width, win_height);
+    if (!window) {
+        std::cout << "Failed to initialize OpenGL context" << std::endl;
+        return -1;
+    }
+    stbi_set_flip_vertically_on_load(true);
+    gl_print_debug_info();
+
+    const glm::vec3 camera_pos = glm::vec3(GRID_WIDTH * GRID_SPACING * 0.5f, 10.0f, GRID_DEPTH * GRID_SPACING + 10.0f);
+    Camera camera(1.0f, camera_pos);
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    GlfwContainer container{camera, win_width, win_height};
+    glfwSetWindowUserPointer(window, &container);
+    glfwSetCursorPosCallback(window, [](GLFWwindow *w, double x, double y) {
+        static bool first_time = false;
+        static double last_x = 0.0;
+        static double last_y = 0.0;
+        if (const GlfwContainer *c = static_cast<GlfwContainer *>(glfwGetWindowUserPointer(w))) {
+            if (first_time) {
+                last_x = x;
+                last_y = y;
+                first_time = false;
+            }
+            c->camera.update_euler_angles(x - last_x, last_y - y);
+            last_x = x;
+            last_y = y;
+        }
+    });
+
+    Shader object_shader("shader.vert", "shader.frag");
+    Shader indirect_shader("indirect.vert", "indirect.frag");
+
+    GL_CALL(glEnable(GL_DEPTH_TEST));
+
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), win_width / static_cast<float>(win_height), 0.1f,
+                                            500.0f);
+
+    // the indirect path reads the textures once, so they are loaded synchronously here
+    ModelOptions model_options;
+    model_options.optimizeMeshes = true;
+    model_options.upload.format = VertexFormat::CompactQuantized;
+    model_options.upload.splitIndexRanges = true;
+    model_options.upload.sharedGeometry = true;
+    Model backpack_model("backpack/backpack.obj", model_options);
+
+    std::vector<glm::mat4> instances;
+    instances.reserve(GRID_WIDTH * GRID_DEPTH);
+    for (int z = 0; z < GRID_DEPTH; ++z) {
+        for (int x = 0; x < GRID_WIDTH; ++x) {
+            glm::mat4 model(1.0f);
+            model = glm::translate(model, glm::vec3(x * GRID_SPACING, 0.0f, z * GRID_SPACING));
+            instances.push_back(model);
+        }
+    }
+
+    IndirectModelDraw indirect_draw(backpack_model);
+    indirect_draw.set_instances(instances);
+    std::cout << instances.size() << " instances, " << backpack_model.meshes.size() << " meshes, "
+              << indirect_draw.get_command_count() << " indirect commands" << std::endl;
+
+    for (Shader *shader : {&object_shader, &indirect_shader}) {
+        shader->set_uniform_block_binding("CameraBlock", CAMERA_BLOCK_BINDING);
+        shader->set_uniform_block_binding("LightsBlock", LIGHTS_BLOCK_BINDING);
+    }
+    UniformBuffer camera_ubo(sizeof(CameraBlock), CAMERA_BLOCK_BINDING);
+    UniformBuffer lights_ubo(sizeof(LightsBlock), LIGHTS_BLOCK_BINDING);
+
+    LightsBlock lights{};
+    lights.dir_light.direction = {-0.2f, -1.0f, -0.3f};
+    lights.dir_light.ambient = {0.05f, 0.05f, 0.05f};
+    lights.dir_light.diffuse = {0.4f, 0.4f, 0.4f};
+    lights.dir_light.specular = {1.0f, 1.0f, 1.0f};
+    lights.num_point_lights = 0;
+    lights_ubo.set_data(lights);
+
+    const UniformHandle model_uniform = object_shader.get_uniform("model");
+
+    bool use_indirect = indirect_draw.is_valid();
+    bool toggle_pressed = false;
+    CpuTimer per_mesh_timer("draw submission, Model::Draw per instance");
+    CpuTimer indirect_timer("draw submission, multi draw indirect");
+
+    double begin = glfwGetTime();
+    double end = 0.0;
+    double time_span = 0.0;
+
+    while (!glfwWindowShouldClose(window)) {
+        end = glfwGetTime();
+        time_span = end - begin;
+        begin = end;
+        process_input(window, camera, time_span);
+
+        const bool toggle_down = glfwGetKey(window, GLFW_KEY_I) == GLFW_PRESS;
+        if (toggle_down && !toggle_pressed && indirect_draw.is_valid()) {
+            use_indirect = !use_indirect;
+            std::cout << (use_indirect ? "multi draw indirect" : "Model::Draw per instance") << std::endl;
+        }
+        toggle_pressed = toggle_down;
+
+        if (container.win_height != win_height || container.win_width != win_width) {
+            win_height = container.win_height;
+            win_width = container.win_width;
+            projection = glm::perspective(glm::radians(45.0f), win_width / static_cast<float>(win_height), 0.1f,
+                                          500.0f);
+        }
+
+        GL_CALL(glClearColor(0.0f, 0.0f, 0.0f, 1.0f));
+        GL_CALL(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+
+        CameraBlock camera_block;
+        camera_block.view = camera.get_view();
+        camera_block.projection = projection;
+        camera_block.view_pos = camera.get_position();
+        camera_ubo.set_data(camera_block);
+
+        if (use_indirect) {
+            indirect_timer.begin();
+            indirect_shader.use();
+            indirect_draw.draw(indirect_shader);
+            indirect_timer.end();
+        } else {
+            per_mesh_timer.begin();
+            object_shader.use();
+            for (const glm::mat4 &model : instances) {
+                object_shader.set_mat4(model_uniform, model);
+                backpack_model.Draw(object_shader);
+            }
+            per_mesh_timer.end();
+        }
+
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
+}
@@ -0,0 +1,14 @@
+#version 330 core
+
+in vec3 normal;
+in vec3 color;
+
+out vec4 frag_color;
+
+uniform vec3 light_direction;
+
+void main()
+{
+	float diff = max(dot(normalize(normal), normalize(-light_direction)), 0.0);
+	frag_color = vec4(color * (0.1 + 0.9 * diff), 1.0);
+}
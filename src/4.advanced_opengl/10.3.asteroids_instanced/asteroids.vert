@@ -0,0 +1,24 @@
+#version 330 core
+
+layout (location = 0) in vec3 in_position;
+layout (location = 1) in vec3 in_normal;
+// per instance, see instance_buffer.h
+layout (location = 8) in mat4 in_instance_model;
+layout (location = 12) in vec4 in_instance_color;
+
+layout (std140) uniform CameraBlock {
+	mat4 view;
+	mat4 projection;
+	vec3 view_pos;
+};
+
+out vec3 normal;
+out vec3 color;
+
+void main()
+{
+	// instances are only scaled uniformly, so the model matrix can transform the normal
+	normal = mat3(in_instance_model) * in_normal;
+	color = in_instance_color.rgb;
+	gl_Position = projection * view * in_instance_model * vec4(in_position, 1.0);
+}
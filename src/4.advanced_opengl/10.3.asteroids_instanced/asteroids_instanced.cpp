@@ -0,0 +1,241 @@
+//
+// A planet surrounded by a ring of 100000 rocks. Every rock is an instance of
+// the same procedural mesh, the whole ring is drawn with a single instanced
+// draw call through InstanceBuffer. The CPU time spent submitting the draws
+// is printed every 500 frames.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "camera.h"
+#include "cpu_timer.h"
+#include "instance_buffer.h"
+#include "mesh.h"
+#include "shader.h"
+#include "stream_buffer.h"
+#include "uniform_blocks.h"
+#include "utility.h"
+
+constexpr unsigned int ROCK_COUNT = 100000;
+constexpr float RING_RADIUS = 150.0f;
+constexpr float RING_OFFSET = 25.0f;
+
+void process_input(GLFWwindow *window, Camera &camera, double delta_time) {
+    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, GLFW_TRUE);
+
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+        camera.update_pos(Direction::FORWARD, delta_time);
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+        camera.update_pos(Direction::BACKWARD, delta_time);
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+        camera.update_pos(Direction::LEFT, delta_time);
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+        camera.update_pos(Direction::RIGHT, delta_time);
+
+    camera.toggle_acceleration(glfwGetKey(window, GLFW_KEY_LEFT_CONTROL) == GLFW_PRESS);
+}
+
+float random_float(float min, float max) {
+    return min + (max - min) * (static_cast<float>(std::rand()) / RAND_MAX);
+}
+
+// unit icosahedron subdivided `subdivisions` times, every vertex is pushed out
+// by a random amount up to `jitter` to make it look like a rock
+Mesh make_sphere(unsigned int subdivisions, float jitter) {
+    const float t = (1.0f + std::sqrt(5.0f)) / 2.0f;
+    std::vector<glm::vec3> positions = {
+            {-1.0f, t, 0.0f}, {1.0f, t, 0.0f}, {-1.0f, -t, 0.0f}, {1.0f, -t, 0.0f},
+            {0.0f, -1.0f, t}, {0.0f, 1.0f, t}, {0.0f, -1.0f, -t}, {0.0f, 1.0f, -t},
+            {t, 0.0f, -1.0f}, {t, 0.0f, 1.0f}, {-t, 0.0f, -1.0f}, {-t, 0.0f, 1.0f},
+    };
+    std::vector<unsigned int> indices = {
+            0, 11, 5, 0, 5, 1, 0, 1, 7, 0, 7, 10, 0, 10, 11,
+            1, 5, 9, 5, 11, 4, 11, 10, 2, 10, 7, 6, 7, 1, 8,
+            3, 9, 4, 3, 4, 2, 3, 2, 6, 3, 6, 8, 3, 8, 9,
+            4, 9, 5, 2, 4, 11, 6, 2, 10, 8, 6, 7, 9, 8, 1,
+    };
+    for (glm::vec3 &p : positions)
+        p = glm::normalize(p);
+
+    for (unsigned int s = 0; s < subdivisions; ++s) {
+        std::map<std::pair<unsigned int, unsigned int>, unsigned int> midpoints;
+        const auto midpoint = [&](unsigned int a, unsigned int b) {
+            const auto key = std::minmax(a, b);
+            const auto it = midpoints.find(key);
+            if (it != midpoints.end())
+                return it->second;
+            positions.push_back(glm::normalize((positions[a] + positions[b]) * 0.5f));
+            const auto index = static_cast<unsigned int>(positions.size() - 1);
+            midpoints.emplace(key, index);
+            return index;
+        };
+
+        std::vector<unsigned int> subdivided;
+        subdivided.reserve(indices.size() * 4);
+        for (size_t i = 0; i < indices.size(); i += 3) {
+            const unsigned int a = indices[i];
+            const unsigned int b = indices[i + 1];
+            const unsigned int c = indices[i + 2];
+            const unsigned int ab = midpoint(a, b);
+            const unsigned int bc = midpoint(b, c);
+            const unsigned int ca = midpoint(c, a);
+            subdivided.insert(subdivided.end(), {a, ab, ca, b, bc, ab, c, ca, bc, ab, bc, ca});
+        }
+        indices = std::move(subdivided);
+    }
+
+    for (glm::vec3 &p : positions)
+        p = p * (1.0f + random_float(0.0f, jitter));
+
+    // smooth normals from the displaced surface
+    std::vector<Vertex> vertices(positions.size(), Vertex{});
+    for (size_t i = 0; i < positions.size(); ++i)
+        vertices[i].Position = positions[i];
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        const glm::vec3 &a = positions[indices[i]];
+        const glm::vec3 &b = positions[indices[i + 1]];
+        const glm::vec3 &c = positions[indices[i + 2]];
+        const glm::vec3 face_normal = glm::cross(b - a, c - a);
+        for (size_t k = 0; k < 3; ++k)
+            vertices[indices[i + k]].Normal += face_normal;
+    }
+    for (Vertex &v : vertices)
+        v.Normal = glm::normalize(v.Normal);
+
+    return Mesh(vertices, indices, {});
+}
+
+int main() {
+    int win_width = 800;
+    int win_height = 600;
+
+    GLFWwindow *window = init_gl_context(win_width, win_height);
+    if (!window) {
+        std::cout << "Failed to initialize OpenGL context" << std::endl;
+        return -1;
+    }
+    gl_print_debug_info();
+
+    const glm::vec3 camera_pos = glm::vec3(0.0f, 30.0f, RING_RADIUS + 80.0f);
+    Camera camera(10.0f, camera_pos);
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    GlfwContainer container{camera, win_width, win_height};
+    glfwSetWindowUserPointer(window, &container);
+    glfwSetCursorPosCallback(window, [](GLFWwindow *w, double x, double y) {
+        static bool first_time = false;
+        static double last_x = 0.0;
+        static double last_y = 0.0;
+        if (const GlfwContainer *c = static_cast<GlfwContainer *>(glfwGetWindowUserPointer(w))) {
+            if (first_time) {
+                last_x = x;
+                last_y = y;
+                first_time = false;
+            }
+            c->camera.update_euler_angles(x - last_x, last_y - y);
+            last_x = x;
+            last_y = y;
+        }
+    });
+
+    Shader shader("asteroids.vert", "asteroids.frag");
+
+    GL_CALL(glEnable(GL_DEPTH_TEST));
+
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), win_width / static_cast<float>(win_height), 0.1f,
+                                            1000.0f);
+
+    std::srand(static_cast<unsigned int>(glfwGetTime() * 1000.0));
+    Mesh rock = make_sphere(1, 0.3f);
+    Mesh planet = make_sphere(4, 0.0f);
+
+    // same ring layout as the non instanced asteroids demo
+    std::vector<glm::mat4> rock_models;
+    std::vector<glm::vec4> rock_colors;
+    rock_models.reserve(ROCK_COUNT);
+    rock_colors.reserve(ROCK_COUNT);
+    for (unsigned int i = 0; i < ROCK_COUNT; ++i) {
+        const float angle = static_cast<float>(i) / ROCK_COUNT * 360.0f;
+        const float x = std::sin(glm::radians(angle)) * RING_RADIUS + random_float(-RING_OFFSET, RING_OFFSET);
+        const float y = random_float(-RING_OFFSET, RING_OFFSET) * 0.4f;
+        const float z = std::cos(glm::radians(angle)) * RING_RADIUS + random_float(-RING_OFFSET, RING_OFFSET);
+
+        glm::mat4 model(1.0f);
+        model = glm::translate(model, glm::vec3(x, y, z));
+        model = glm::scale(model, glm::vec3(random_float(0.05f, 0.25f)));
+        model = glm::rotate(model, glm::radians(random_float(0.0f, 360.0f)), glm::vec3(0.4f, 0.6f, 0.8f));
+        rock_models.push_back(model);
+
+        const float grey = random_float(0.35f, 0.6f);
+        rock_colors.emplace_back(grey, grey * 0.95f, grey * 0.9f, 1.0f);
+    }
+
+    InstanceBuffer rock_instances(ROCK_COUNT);
+    rock_instances.set_instances(rock_models, rock_colors);
+
+    const glm::mat4 planet_model = glm::scale(glm::mat4(1.0f), glm::vec3(40.0f));
+    const glm::vec4 planet_color(0.8f, 0.5f, 0.3f, 1.0f);
+    InstanceBuffer planet_instance(1);
+    planet_instance.set_instances({&planet_model, 1}, {&planet_color, 1});
+
+    std::cout << ROCK_COUNT << " rocks, " << rock.indices.size() / 3 << " triangles each" << std::endl;
+
+    shader.set_uniform_block_binding("CameraBlock", CAMERA_BLOCK_BINDING);
+    // the camera block is rewritten every frame, so it goes through a persistently mapped ring
+    StreamBuffer frame_stream(sizeof(CameraBlock));
+    shader.use();
+    shader.set_vec3("light_direction", glm::vec3(-0.2f, -1.0f, -0.3f));
+
+    CpuTimer draw_timer("draw submission, instanced");
+
+    double begin = glfwGetTime();
+    double end = 0.0;
+    double time_span = 0.0;
+
+    while (!glfwWindowShouldClose(window)) {
+        end = glfwGetTime();
+        time_span = end - begin;
+        begin = end;
+        process_input(window, camera, time_span);
+
+        if (container.win_height != win_height || container.win_width != win_width) {
+            win_height = container.win_height;
+            win_width = container.win_width;
+            projection = glm::perspective(glm::radians(45.0f), win_width / static_cast<float>(win_height), 0.1f,
+                                          1000.0f);
+        }
+
+        GL_CALL(glClearColor(0.0f, 0.0f, 0.0f, 1.0f));
+        GL_CALL(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+
+        frame_stream.begin_frame();
+        const StreamBuffer::Allocation camera_block = frame_stream.allocate(sizeof(CameraBlock), StreamBuffer::get_uniform_alignment());
+        auto *block = static_cast<CameraBlock*>(camera_block.data);
+        block->view = camera.get_view();
+        block->projection = projection;
+        block->view_pos = camera.get_position();
+        frame_stream.flush();
+        frame_stream.bind_range(GL_UNIFORM_BUFFER, CAMERA_BLOCK_BINDING, camera_block.offset, sizeof(CameraBlock));
+
+        draw_timer.begin();
+        shader.use();
+        planet.DrawInstanced(shader, planet_instance);
+        rock.DrawInstanced(shader, rock_instances);
+        draw_timer.end();
+        frame_stream.end_frame();
+
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
+}
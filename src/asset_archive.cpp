@@ -0,0 +1,191 @@
+#include "asset_archive.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "content_hash.h"
+#include "lz4_block.h"
+
+static constexpr char ASSET_ARCHIVE_MAGIC[8] = {'L', 'O', 'G', 'L', 'P', 'A', 'C', 'K'};
+
+static_assert(sizeof(AssetArchiveHeader) == 40 && sizeof(AssetArchiveEntry) == 48);
+
+static std::uint64_t align_up(std::uint64_t value, std::uint64_t alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+static std::uint64_t hash_name(std::string_view name)
+{
+	return hash_bytes(name.data(), name.size());
+}
+
+bool AssetArchive::open(const std::string &archive_path)
+{
+	path = archive_path;
+	entries = {};
+	strings = {};
+	// the entries are mostly read in order, reading ahead pays off
+	if (!file.open(path, MappedFile::Access::Sequential)) {
+		std::cerr << "Failed to open asset archive " << path << std::endl;
+		return false;
+	}
+
+	const std::uint64_t file_size = file.get_size();
+	const unsigned char *data = file.get_data();
+	AssetArchiveHeader header;
+	if (file_size < sizeof(header)) {
+		std::cerr << "Asset archive " << path << " is truncated" << std::endl;
+		file.close();
+		return false;
+	}
+	std::memcpy(&header, data, sizeof(header));
+
+	const auto in_bounds = [&](std::uint64_t offset, std::uint64_t size) {
+		return offset <= file_size && size <= file_size - offset;
+	};
+	if (std::memcmp(header.magic, ASSET_ARCHIVE_MAGIC, sizeof(header.magic)) != 0
+		|| header.version != ASSET_ARCHIVE_VERSION
+		|| header.file_size != file_size
+		|| !in_bounds(sizeof(header), std::uint64_t(header.entry_count) * sizeof(AssetArchiveEntry))
+		|| !in_bounds(header.string_table_offset, header.string_table_size)) {
+		std::cerr << "Asset archive " << path << " is not a version " << ASSET_ARCHIVE_VERSION << " archive or is truncated" << std::endl;
+		file.close();
+		return false;
+	}
+
+	entries = {reinterpret_cast<const AssetArchiveEntry*>(data + sizeof(header)), header.entry_count};
+	strings = {reinterpret_cast<const char*>(data + header.string_table_offset), static_cast<size_t>(header.string_table_size)};
+	for (const AssetArchiveEntry &entry : entries) {
+		if (!in_bounds(entry.offset, entry.size) || std::uint64_t(entry.name_offset) + entry.name_length > strings.size()
+			|| (entry.compression != AssetCompression::None && entry.compression != AssetCompression::LZ4)
+			|| (entry.compression == AssetCompression::None && entry.size != entry.decompressed_size)) {
+			std::cerr << "Asset archive " << path << " has a malformed entry" << std::endl;
+			entries = {};
+			strings = {};
+			file.close();
+			return false;
+		}
+	}
+	return true;
+}
+
+const AssetArchiveEntry* AssetArchive::find(std::string_view name) const
+{
+	const std::uint64_t hash = hash_name(name);
+	auto it = std::lower_bound(entries.begin(), entries.end(), hash,
+		[](const AssetArchiveEntry &entry, std::uint64_t value) { return entry.name_hash < value; });
+	for (; it != entries.end() && it->name_hash == hash; ++it) {
+		if (get_name(*it) == name)
+			return &*it;
+	}
+	return nullptr;
+}
+
+std::string_view AssetArchive::get_name(const AssetArchiveEntry &entry) const
+{
+	return strings.substr(entry.name_offset, entry.name_length);
+}
+
+const unsigned char* AssetArchive::get_data(const AssetArchiveEntry &entry) const
+{
+	return file.get_data() + entry.offset;
+}
+
+void AssetArchive::prefetch(const AssetArchiveEntry &entry) const
+{
+	file.prefetch(static_cast<size_t>(entry.offset), static_cast<size_t>(entry.size));
+}
+
+std::span<const AssetArchiveEntry> AssetArchive::get_entries() const
+{
+	return entries;
+}
+
+const std::string& AssetArchive::get_path() const
+{
+	return path;
+}
+
+bool write_asset_archive(const std::string &path, const std::vector<AssetArchiveSource> &sources, bool compress,
+	AssetArchiveStats &stats)
+{
+	stats = {sources.size(), 0, 0, 0};
+	std::vector<AssetArchiveEntry> entries(sources.size());
+	std::string strings;
+	for (size_t i = 0; i < sources.size(); ++i) {
+		AssetArchiveEntry &entry = entries[i];
+		entry = {};
+		entry.name_hash = hash_name(sources[i].name);
+		entry.name_offset = static_cast<std::uint32_t>(strings.size());
+		entry.name_length = static_cast<std::uint32_t>(sources[i].name.size());
+		strings += sources[i].name;
+	}
+
+	AssetArchiveHeader header{};
+	std::memcpy(header.magic, ASSET_ARCHIVE_MAGIC, sizeof(header.magic));
+	header.version = ASSET_ARCHIVE_VERSION;
+	header.entry_count = static_cast<std::uint32_t>(entries.size());
+	header.string_table_offset = sizeof(header) + entries.size() * sizeof(AssetArchiveEntry);
+	header.string_table_size = strings.size();
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file) {
+		std::cerr << "Failed to write asset archive " << path << std::endl;
+		return false;
+	}
+	const auto write_at = [&](std::uint64_t at, const void *data, std::uint64_t size) {
+		static const char padding[ASSET_ARCHIVE_ALIGNMENT] = {};
+		const auto position = static_cast<std::uint64_t>(file.tellp());
+		file.write(padding, static_cast<std::streamsize>(at - position));
+		file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+	};
+
+	// the table is written once the offsets are known, the data follows the string table
+	std::uint64_t offset = header.string_table_offset + strings.size();
+	file.seekp(static_cast<std::streamoff>(offset));
+	for (size_t i = 0; i < sources.size(); ++i) {
+		MappedFile source;
+		if (!source.open(sources[i].path, MappedFile::Access::Sequential)) {
+			std::cerr << "Failed to read " << sources[i].path << " for asset archive " << path << std::endl;
+			return false;
+		}
+
+		AssetArchiveEntry &entry = entries[i];
+		entry.decompressed_size = source.get_size();
+		entry.size = source.get_size();
+		entry.compression = AssetCompression::None;
+		const unsigned char *data = source.get_data();
+		std::vector<unsigned char> compressed;
+		if (compress && source.get_size() > 0) {
+			compressed = lz4_compress(source.get_data(), source.get_size());
+			if (compressed.size() <= source.get_size() - source.get_size() / 4) {
+				entry.compression = AssetCompression::LZ4;
+				entry.size = compressed.size();
+				data = compressed.data();
+				++stats.compressed_count;
+			}
+		}
+
+		offset = align_up(offset, ASSET_ARCHIVE_ALIGNMENT);
+		entry.offset = offset;
+		write_at(offset, data, entry.size);
+		offset += entry.size;
+		stats.source_size += source.get_size();
+	}
+	header.file_size = offset;
+	stats.archive_size = offset;
+
+	std::sort(entries.begin(), entries.end(), [](const AssetArchiveEntry &a, const AssetArchiveEntry &b) { return a.name_hash < b.name_hash; });
+	file.seekp(0);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(AssetArchiveEntry)));
+	file.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+	if (!file) {
+		std::cerr << "Failed to write asset archive " << path << std::endl;
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,172 @@
+#include "async_texture_loader.h"
+
+#include <glad/glad.h>
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include <stb_image.h>
+
+#include "gl_state_cache.h"
+#include "texture_upload.h"
+#include "utility.h"
+
+// no levels when the image cannot be decoded
+static MipChain decode_image(const std::string &image_path, bool srgb, int desired_channels)
+{
+	MipChain mips{};
+	int width = 0, height = 0, channels = 0;
+	if (unsigned char *pixels = decode_image_file(image_path, width, height, channels, desired_channels)) {
+		mips = generate_mip_chain(pixels, width, height, desired_channels ? desired_channels : channels, srgb);
+		stbi_image_free(pixels);
+	}
+	return mips;
+}
+
+AsyncTextureLoader::AsyncTextureLoader(ThreadPool &pool):
+	pool(pool),
+	next_ticket(0),
+	in_flight(0),
+	pending(0)
+{
+}
+
+AsyncTextureLoader::~AsyncTextureLoader()
+{
+	// the tasks push into this object, so it has to outlive them
+	while (in_flight.load(std::memory_order_acquire) != 0)
+		std::this_thread::yield();
+}
+
+unsigned int AsyncTextureLoader::load(const std::string &image_path, bool srgb, int channels)
+{
+	unsigned int texture_id = 0;
+	GL_CALL(glGenTextures(1, &texture_id));
+	load_into(texture_id, image_path, srgb, channels);
+	return texture_id;
+}
+
+void AsyncTextureLoader::load_into(unsigned int texture_id, const std::string &image_path, bool srgb, int channels)
+{
+	// mid grey keeps lit surfaces readable while the real image is decoding
+	static constexpr unsigned char placeholder[4] = {128, 128, 128, 255};
+	GLStateCache::get().bind_texture(GL_TEXTURE_2D, texture_id);
+	GL_CALL(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholder));
+	set_texture_sampling(texture_id, GL_LINEAR);
+
+	const std::uint64_t ticket = next_ticket++;
+	awaited_tickets[texture_id] = ticket;
+	++pending;
+	in_flight.fetch_add(1, std::memory_order_relaxed);
+	pool.submit([this, texture_id, ticket, image_path, srgb, channels] {
+		// a compressed file is only mapped here, the kernel reads it in while the image waits for its upload
+		DecodedImage image{texture_id, ticket, srgb, channels, {}, {}, image_path};
+		const std::string compressed_path = find_compressed_texture(image_path);
+		if (compressed_path.empty() || !read_compressed_image(compressed_path, image.compressed))
+			image.mips = decode_image(image_path, srgb, channels);
+		decoded.push(std::move(image));
+		in_flight.fetch_sub(1, std::memory_order_release);
+	});
+}
+
+unsigned int AsyncTextureLoader::upload_pending(double budget_ms)
+{
+	decoded.consume_all([this](DecodedImage &&image) { ready.push_back(std::move(image)); });
+
+	const auto start = std::chrono::steady_clock::now();
+	unsigned int uploads = 0;
+	while (!ready.empty()) {
+		if (uploads > 0) {
+			const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+			if (elapsed.count() >= budget_ms)
+				break;
+		}
+
+		DecodedImage image = std::move(ready.front());
+		ready.pop_front();
+		--pending;
+
+		const auto it = awaited_tickets.find(image.texture_id);
+		if (it == awaited_tickets.end() || it->second != image.ticket)
+			continue;
+		awaited_tickets.erase(it);
+		upload(image);
+		++uploads;
+	}
+	return uploads;
+}
+
+void AsyncTextureLoader::cancel(unsigned int texture_id)
+{
+	awaited_tickets.erase(texture_id);
+}
+
+bool AsyncTextureLoader::is_idle() const
+{
+	return pending == 0;
+}
+
+unsigned int AsyncTextureLoader::get_pending_count() const
+{
+	return pending;
+}
+
+void AsyncTextureLoader::upload(const DecodedImage &image)
+{
+	if (!image.compressed.levels.empty()) {
+		if (is_block_format_supported(image.compressed.format)) {
+			upload(image.texture_id, image.compressed, image.srgb);
+			return;
+		}
+		// rare enough to decode the source right here instead of queueing it again
+		std::cerr << "Compressed texture for " << image.path << " needs S3TC, which the driver does not support" << std::endl;
+		const MipChain mips = decode_image(image.path, image.srgb, image.channels);
+		if (!mips.levels.empty())
+			upload(image.texture_id, mips);
+		else
+			std::cerr << "Failed to load texture from file " << image.path << std::endl;
+		return;
+	}
+
+	if (image.mips.levels.empty()) {
+		std::cerr << "Failed to load texture from file "
+			<< image.path << std::endl;
+		return;
+	}
+	upload(image.texture_id, image.mips);
+}
+
+// the texture id was handed out with the placeholder, so the storage stays
+// mutable and is respecified here instead of using create_texture_2d
+void AsyncTextureLoader::upload(unsigned int texture_id, const MipChain &mips)
+{
+	const TextureFormat format = get_texture_format(mips.channels, mips.srgb);
+	const auto max_level = static_cast<GLint>(mips.levels.size() - 1);
+	GL_CALL(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+	GLStateCache::get().bind_texture(GL_TEXTURE_2D, texture_id);
+	for (GLint i = 0; i <= max_level; ++i) {
+		const MipLevel &level = mips.levels[i];
+		GL_CALL(glTexImage2D(GL_TEXTURE_2D, i, format.internal_format, level.width, level.height, 0, format.format,
+			GL_UNSIGNED_BYTE, mips.data.data() + level.offset));
+	}
+	GL_CALL(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+	// a texture used before with a longer chain keeps its stale lower levels, never sample them
+	GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, max_level));
+	set_texture_sampling(texture_id, GL_LINEAR_MIPMAP_LINEAR);
+}
+
+void AsyncTextureLoader::upload(unsigned int texture_id, const CompressedImage &image, bool srgb)
+{
+	const GLenum internal_format = get_compressed_internal_format(image.format, srgb);
+	const auto max_level = static_cast<GLint>(image.levels.size() - 1);
+	GLStateCache::get().bind_texture(GL_TEXTURE_2D, texture_id);
+	for (GLint i = 0; i <= max_level; ++i) {
+		const MipLevel &level = image.levels[i];
+		const auto size = static_cast<GLsizei>(get_compressed_level_size(image.format, level.width, level.height));
+		GL_CALL(glCompressedTexImage2D(GL_TEXTURE_2D, i, internal_format, level.width, level.height, 0, size,
+			image.get_level_data(i)));
+	}
+	GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, max_level));
+	set_texture_sampling(texture_id, GL_LINEAR_MIPMAP_LINEAR);
+}
@@ -0,0 +1,24 @@
+#include "content_hash.h"
+
+#include "mapped_file.h"
+
+std::uint64_t hash_bytes(const void* data, size_t size, std::uint64_t seed)
+{
+    const auto bytes = static_cast<const unsigned char*>(data);
+    std::uint64_t hash = seed;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+bool hash_file(const std::string& path, std::uint64_t& hash)
+{
+    MappedFile file;
+    if (!file.open(path, MappedFile::Access::Sequential))
+        return false;
+
+    hash = hash_bytes(file.get_data(), file.get_size());
+    return true;
+}
@@ -0,0 +1,42 @@
+#include "cpu_timer.h"
+
+#include <iostream>
+
+CpuTimer::CpuTimer(std::string label, unsigned int report_interval):
+	label(std::move(label)),
+	start(),
+	total(0),
+	samples(0),
+	report_interval(report_interval)
+{
+}
+
+void CpuTimer::begin()
+{
+	start = std::chrono::steady_clock::now();
+}
+
+void CpuTimer::end()
+{
+	total += std::chrono::steady_clock::now() - start;
+	++samples;
+	if (report_interval && samples == report_interval) {
+		std::cout << label << ": "
+			<< get_average_us() << " us avg over "
+			<< samples << " samples" << std::endl;
+		reset();
+	}
+}
+
+void CpuTimer::reset()
+{
+	total = std::chrono::steady_clock::duration(0);
+	samples = 0;
+}
+
+double CpuTimer::get_average_us() const
+{
+	if (!samples)
+		return 0.0;
+	return std::chrono::duration<double, std::micro>(total).count() / samples;
+}
@@ -0,0 +1,178 @@
+#include "geometry_arena.h"
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+#include "gl_state_cache.h"
+#include "utility.h"
+
+// index ranges start on 4 bytes so both 16 and 32 bit indices stay aligned
+static constexpr size_t INDEX_ALIGNMENT = 4;
+
+static unsigned int create_buffer(size_t size)
+{
+	unsigned int buffer = 0;
+	GL_CALL(glGenBuffers(1, &buffer));
+	GLStateCache::get().bind_buffer(GL_COPY_WRITE_BUFFER, buffer);
+	GL_CALL(glBufferData(GL_COPY_WRITE_BUFFER, size, nullptr, GL_STATIC_DRAW));
+	return buffer;
+}
+
+GeometryArena::GeometryArena(const VertexBufferLayout &layout, size_t vertex_capacity, size_t index_capacity):
+	vertex_array(0),
+	vertex_buffer(create_buffer(vertex_capacity)),
+	index_buffer(create_buffer(index_capacity)),
+	draw_id_buffer(0),
+	draw_id_count(0),
+	layout(layout),
+	vertex_stride(layout.get_stride()),
+	vertex_count(0),
+	vertex_capacity(vertex_capacity),
+	index_bytes(0),
+	index_capacity(index_capacity)
+{
+	GL_CALL(glGenVertexArrays(1, &vertex_array));
+	setup_vertex_array();
+}
+
+GeometryArena::~GeometryArena()
+{
+	GLStateCache& state = GLStateCache::get();
+	GL_CALL(glDeleteVertexArrays(1, &vertex_array));
+	state.on_vertex_array_deleted(vertex_array);
+	GL_CALL(glDeleteBuffers(1, &vertex_buffer));
+	state.on_buffer_deleted(vertex_buffer);
+	GL_CALL(glDeleteBuffers(1, &index_buffer));
+	state.on_buffer_deleted(index_buffer);
+	if (draw_id_buffer) {
+		GL_CALL(glDeleteBuffers(1, &draw_id_buffer));
+		state.on_buffer_deleted(draw_id_buffer);
+	}
+}
+
+void GeometryArena::setup_vertex_array()
+{
+	GLStateCache& state = GLStateCache::get();
+	state.bind_vertex_array(vertex_array);
+	state.bind_buffer(GL_ARRAY_BUFFER, vertex_buffer);
+	state.bind_buffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
+	layout.apply();
+
+	if (draw_id_buffer) {
+		static constexpr VertexBufferElement DRAW_ID_ELEMENT[] = {
+			{DRAW_ID_ATTRIBUTE, 1, GL_UNSIGNED_INT, AttributeKind::Integer, 0},
+		};
+		state.bind_buffer(GL_ARRAY_BUFFER, draw_id_buffer);
+		VertexBufferLayout(DRAW_ID_ELEMENT, sizeof(unsigned int), 1).apply();
+	}
+}
+
+void GeometryArena::reserve_draw_ids(size_t count)
+{
+	if (count <= draw_id_count)
+		return;
+
+	// the ids are the same for every user of the arena, so one growing buffer serves all
+	draw_id_count = std::max(count, draw_id_count * 2);
+	std::vector<unsigned int> ids(draw_id_count);
+	std::iota(ids.begin(), ids.end(), 0u);
+
+	if (!draw_id_buffer)
+		GL_CALL(glGenBuffers(1, &draw_id_buffer));
+	GLStateCache::get().bind_buffer(GL_COPY_WRITE_BUFFER, draw_id_buffer);
+	GL_CALL(glBufferData(GL_COPY_WRITE_BUFFER, ids.size() * sizeof(unsigned int), ids.data(), GL_STATIC_DRAW));
+	setup_vertex_array();
+}
+
+void GeometryArena::grow(unsigned int &buffer, size_t used, size_t &capacity, size_t required)
+{
+	const size_t new_capacity = std::max(capacity * 2, required);
+	const unsigned int new_buffer = create_buffer(new_capacity);
+
+	GLStateCache& state = GLStateCache::get();
+	state.bind_buffer(GL_COPY_READ_BUFFER, buffer);
+	state.bind_buffer(GL_COPY_WRITE_BUFFER, new_buffer);
+	if (used > 0)
+		GL_CALL(glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, used));
+	GL_CALL(glDeleteBuffers(1, &buffer));
+	state.on_buffer_deleted(buffer);
+
+	buffer = new_buffer;
+	capacity = new_capacity;
+}
+
+unsigned int GeometryArena::add_vertices(const void *data, size_t count)
+{
+	const size_t offset = vertex_count * vertex_stride;
+	const size_t size = count * vertex_stride;
+	if (offset + size > vertex_capacity) {
+		grow(vertex_buffer, offset, vertex_capacity, offset + size);
+		// the attribute pointers still reference the old buffer
+		setup_vertex_array();
+	}
+
+	GLStateCache::get().bind_buffer(GL_COPY_WRITE_BUFFER, vertex_buffer);
+	GL_CALL(glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data));
+
+	const unsigned int base_vertex = static_cast<unsigned int>(vertex_count);
+	vertex_count += count;
+	return base_vertex;
+}
+
+size_t GeometryArena::add_indices(const void *data, size_t size)
+{
+	const size_t offset = (index_bytes + INDEX_ALIGNMENT - 1) / INDEX_ALIGNMENT * INDEX_ALIGNMENT;
+	if (offset + size > index_capacity) {
+		grow(index_buffer, index_bytes, index_capacity, offset + size);
+		// the element buffer binding is part of the vertex array
+		setup_vertex_array();
+	}
+
+	GLStateCache::get().bind_buffer(GL_COPY_WRITE_BUFFER, index_buffer);
+	GL_CALL(glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data));
+
+	index_bytes = offset + size;
+	return offset;
+}
+
+void GeometryArena::bind() const
+{
+	GLStateCache::get().bind_vertex_array(vertex_array);
+}
+
+unsigned int GeometryArena::get_vertex_array() const
+{
+	return vertex_array;
+}
+
+size_t GeometryArena::get_vertex_count() const
+{
+	return vertex_count;
+}
+
+size_t GeometryArena::get_index_bytes() const
+{
+	return index_bytes;
+}
+
+GeometryArena& GeometryArena::shared(VertexFormat format, bool skinned)
+{
+	// one arena per layout, deliberately leaked, the context may be gone at exit
+	static std::array<std::unique_ptr<GeometryArena>, 6> *arenas = new std::array<std::unique_ptr<GeometryArena>, 6>();
+
+	// Vertex carries the bone attributes either way
+	if (format == VertexFormat::Full)
+		skinned = false;
+	const size_t slot = static_cast<size_t>(format) * 2 + (skinned ? 1 : 0);
+	std::unique_ptr<GeometryArena> &arena = (*arenas)[slot];
+	if (!arena) {
+		if (format == VertexFormat::Full)
+			arena = std::make_unique<GeometryArena>(get_full_vertex_buffer_layout());
+		else
+			arena = std::make_unique<GeometryArena>(get_vertex_buffer_layout(get_packed_vertex_layout(format, skinned)));
+	}
+	return *arena;
+}
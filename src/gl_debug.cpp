@@ -0,0 +1,109 @@
+#include "gl_debug.h"
+
+#include <iostream>
+
+#include "utility.h"
+
+thread_local GlCallSite gl_call_site = {nullptr, nullptr, 0};
+
+static const char *get_source_name(GLenum source)
+{
+	switch (source) {
+	case GL_DEBUG_SOURCE_API: return "API";
+	case GL_DEBUG_SOURCE_WINDOW_SYSTEM: return "WINDOW_SYSTEM";
+	case GL_DEBUG_SOURCE_SHADER_COMPILER: return "SHADER_COMPILER";
+	case GL_DEBUG_SOURCE_THIRD_PARTY: return "THIRD_PARTY";
+	case GL_DEBUG_SOURCE_APPLICATION: return "APPLICATION";
+	default: return "OTHER";
+	}
+}
+
+static const char *get_type_name(GLenum type)
+{
+	switch (type) {
+	case GL_DEBUG_TYPE_ERROR: return "ERROR";
+	case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "DEPRECATED_BEHAVIOR";
+	case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR: return "UNDEFINED_BEHAVIOR";
+	case GL_DEBUG_TYPE_PORTABILITY: return "PORTABILITY";
+	case GL_DEBUG_TYPE_PERFORMANCE: return "PERFORMANCE";
+	case GL_DEBUG_TYPE_MARKER: return "MARKER";
+	default: return "OTHER";
+	}
+}
+
+static const char *get_severity_name(GLenum severity)
+{
+	switch (severity) {
+	case GL_DEBUG_SEVERITY_HIGH: return "HIGH";
+	case GL_DEBUG_SEVERITY_MEDIUM: return "MEDIUM";
+	case GL_DEBUG_SEVERITY_LOW: return "LOW";
+	default: return "NOTIFICATION";
+	}
+}
+
+void APIENTRY gl_debug_message_callback(GLenum source,
+                                        GLenum type,
+                                        GLuint id,
+                                        GLenum severity,
+                                        GLsizei length,
+                                        const GLchar *message,
+                                        const void *user_param)
+{
+	std::cerr << "OPENGL::" << get_type_name(type)
+		<< "::" << get_source_name(source)
+		<< "::" << get_severity_name(severity)
+		<< " (" << id << ") " << message << '\n';
+	if (gl_call_site.call) {
+		std::cerr << "    in call: " << gl_call_site.call
+			<< " " << gl_call_site.file << ":" << gl_call_site.line << '\n';
+	}
+	std::cerr.flush();
+
+	if (type == GL_DEBUG_TYPE_ERROR)
+		ASSERT(false);
+}
+
+void gl_enable_debug_output(bool synchronous)
+{
+	int flags = 0;
+	glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
+	if (!(flags & GL_CONTEXT_FLAG_DEBUG_BIT))
+		std::cerr << "OpenGL context is not a debug context, debug output may be incomplete" << std::endl;
+
+	glEnable(GL_DEBUG_OUTPUT);
+	if (synchronous)
+		glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+	else
+		glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+	glDebugMessageCallback(gl_debug_message_callback, nullptr);
+	gl_set_debug_min_severity(GL_DEBUG_SEVERITY_LOW);
+}
+
+void gl_set_debug_output(bool enabled)
+{
+	if (enabled)
+		glEnable(GL_DEBUG_OUTPUT);
+	else
+		glDisable(GL_DEBUG_OUTPUT);
+}
+
+void gl_set_debug_min_severity(GLenum min_severity)
+{
+	constexpr GLenum severities[] = {
+		GL_DEBUG_SEVERITY_NOTIFICATION,
+		GL_DEBUG_SEVERITY_LOW,
+		GL_DEBUG_SEVERITY_MEDIUM,
+		GL_DEBUG_SEVERITY_HIGH,
+	};
+	bool enabled = false;
+	for (const GLenum severity : severities) {
+		enabled = enabled || severity == min_severity;
+		glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, severity, 0, nullptr, enabled ? GL_TRUE : GL_FALSE);
+	}
+}
+
+void gl_ignore_debug_message(GLenum source, GLenum type, GLuint id)
+{
+	// ids need a specific source and type and apply to every severity
+	glDebugMessageControl(source, type, GL_DONT_CARE, 1, &id, GL_FALSE);
+}
@@ -0,0 +1,66 @@
+#include "gl_extensions.h"
+
+#include <GLFW/glfw3.h>
+
+static bool is_version_at_least(int major, int minor)
+{
+	return GLVersion.major > major || (GLVersion.major == major && GLVersion.minor >= minor);
+}
+
+// resolves name into function, true when the driver has it
+template <typename Function>
+static bool load(Function &function, const char *name)
+{
+	function = reinterpret_cast<Function>(glfwGetProcAddress(name));
+	return function != nullptr;
+}
+
+static GLExtensions load_gl_extensions()
+{
+	GLExtensions ext;
+
+	ext.texture_compression_s3tc = glfwExtensionSupported("GL_EXT_texture_compression_s3tc");
+
+	if (is_version_at_least(4, 1) || glfwExtensionSupported("GL_ARB_get_program_binary")) {
+		bool loaded = true;
+		loaded &= load(ext.GetProgramBinary, "glGetProgramBinary");
+		loaded &= load(ext.ProgramBinary, "glProgramBinary");
+		loaded &= load(ext.ProgramParameteri, "glProgramParameteri");
+		ext.get_program_binary = loaded;
+	}
+
+	if (is_version_at_least(4, 4) || glfwExtensionSupported("GL_ARB_buffer_storage"))
+		ext.buffer_storage = load(ext.BufferStorage, "glBufferStorage");
+
+	if (is_version_at_least(4, 5) || glfwExtensionSupported("GL_ARB_direct_state_access")) {
+		bool loaded = true;
+		loaded &= load(ext.CreateBuffers, "glCreateBuffers");
+		loaded &= load(ext.NamedBufferStorage, "glNamedBufferStorage");
+		loaded &= load(ext.NamedBufferSubData, "glNamedBufferSubData");
+		loaded &= load(ext.CreateTextures, "glCreateTextures");
+		loaded &= load(ext.TextureStorage2D, "glTextureStorage2D");
+		loaded &= load(ext.TextureSubImage2D, "glTextureSubImage2D");
+		loaded &= load(ext.CompressedTextureSubImage2D, "glCompressedTextureSubImage2D");
+		loaded &= load(ext.TextureParameteri, "glTextureParameteri");
+		loaded &= load(ext.GenerateTextureMipmap, "glGenerateTextureMipmap");
+		loaded &= load(ext.BindTextureUnit, "glBindTextureUnit");
+		loaded &= load(ext.CreateVertexArrays, "glCreateVertexArrays");
+		loaded &= load(ext.EnableVertexArrayAttrib, "glEnableVertexArrayAttrib");
+		loaded &= load(ext.VertexArrayVertexBuffer, "glVertexArrayVertexBuffer");
+		loaded &= load(ext.VertexArrayElementBuffer, "glVertexArrayElementBuffer");
+		loaded &= load(ext.VertexArrayAttribFormat, "glVertexArrayAttribFormat");
+		loaded &= load(ext.VertexArrayAttribIFormat, "glVertexArrayAttribIFormat");
+		loaded &= load(ext.VertexArrayAttribBinding, "glVertexArrayAttribBinding");
+		loaded &= load(ext.VertexArrayBindingDivisor, "glVertexArrayBindingDivisor");
+		// glNamedBufferStorage is only usable next to buffer storage
+		ext.direct_state_access = loaded && ext.buffer_storage;
+	}
+
+	return ext;
+}
+
+const GLExtensions& gl_extensions()
+{
+	static const GLExtensions ext = load_gl_extensions();
+	return ext;
+}
@@ -0,0 +1,160 @@
+#include "gl_state_cache.h"
+
+#include <algorithm>
+
+#include "gl_extensions.h"
+#include "utility.h"
+
+template <typename Array>
+static int find_target(const Array& targets, GLenum target)
+{
+	const auto it = std::find(targets.begin(), targets.end(), target);
+	return it == targets.end() ? -1 : static_cast<int>(it - targets.begin());
+}
+
+GLStateCache& GLStateCache::get()
+{
+	// a context is current on a single thread, so one cache per thread is one cache per context
+	thread_local GLStateCache cache;
+	return cache;
+}
+
+GLStateCache::GLStateCache():
+	program(UNKNOWN),
+	vertex_array(UNKNOWN),
+	buffers(),
+	active_unit(UNKNOWN),
+	textures(),
+	counters()
+{
+	invalidate();
+}
+
+bool GLStateCache::changed(unsigned int& cached, unsigned int value)
+{
+	if (cached == value) {
+		++counters.skipped;
+		return false;
+	}
+	cached = value;
+	++counters.issued;
+	return true;
+}
+
+void GLStateCache::use_program(unsigned int program_id)
+{
+	if (changed(program, program_id))
+		GL_CALL(glUseProgram(program_id));
+}
+
+void GLStateCache::bind_vertex_array(unsigned int vertex_array_id)
+{
+	if (changed(vertex_array, vertex_array_id)) {
+		GL_CALL(glBindVertexArray(vertex_array_id));
+		// the element array buffer binding is part of the vertex array state
+		buffers[find_target(buffer_targets, GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+	}
+}
+
+void GLStateCache::bind_buffer(GLenum target, unsigned int buffer)
+{
+	const int index = find_target(buffer_targets, target);
+	if (index < 0) {
+		++counters.issued;
+		GL_CALL(glBindBuffer(target, buffer));
+	}
+	else if (changed(buffers[index], buffer)) {
+		GL_CALL(glBindBuffer(target, buffer));
+	}
+}
+
+void GLStateCache::active_texture(unsigned int unit)
+{
+	if (changed(active_unit, unit))
+		GL_CALL(glActiveTexture(GL_TEXTURE0 + unit));
+}
+
+void GLStateCache::bind_texture(GLenum target, unsigned int texture)
+{
+	const int index = find_target(texture_targets, target);
+	if (index < 0 || active_unit >= MAX_TEXTURE_UNITS) {
+		++counters.issued;
+		GL_CALL(glBindTexture(target, texture));
+	}
+	else if (changed(textures[active_unit][index], texture)) {
+		GL_CALL(glBindTexture(target, texture));
+	}
+}
+
+void GLStateCache::bind_texture(unsigned int unit, GLenum target, unsigned int texture)
+{
+	const int index = find_target(texture_targets, target);
+	// only switch the active unit when the binding actually changes
+	if (index >= 0 && unit < MAX_TEXTURE_UNITS && textures[unit][index] == texture) {
+		++counters.skipped;
+		return;
+	}
+
+	// glBindTextureUnit leaves the active unit alone, unbinding through it clears every target though
+	const GLExtensions& ext = gl_extensions();
+	if (ext.direct_state_access && index >= 0 && unit < MAX_TEXTURE_UNITS && texture != 0) {
+		++counters.issued;
+		textures[unit][index] = texture;
+		GL_CALL(ext.BindTextureUnit(unit, texture));
+		return;
+	}
+	active_texture(unit);
+	bind_texture(target, texture);
+}
+
+void GLStateCache::on_program_deleted(unsigned int program_id)
+{
+	if (program == program_id)
+		program = 0;
+}
+
+void GLStateCache::on_vertex_array_deleted(unsigned int vertex_array_id)
+{
+	if (vertex_array == vertex_array_id) {
+		vertex_array = 0;
+		buffers[find_target(buffer_targets, GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+	}
+}
+
+void GLStateCache::on_buffer_deleted(unsigned int buffer)
+{
+	for (auto& bound : buffers) {
+		if (bound == buffer)
+			bound = 0;
+	}
+}
+
+void GLStateCache::on_texture_deleted(unsigned int texture)
+{
+	for (auto& unit : textures) {
+		for (auto& bound : unit) {
+			if (bound == texture)
+				bound = 0;
+		}
+	}
+}
+
+void GLStateCache::invalidate()
+{
+	program = UNKNOWN;
+	vertex_array = UNKNOWN;
+	buffers.fill(UNKNOWN);
+	active_unit = UNKNOWN;
+	for (auto& unit : textures)
+		unit.fill(UNKNOWN);
+}
+
+const GLStateCache::Counters& GLStateCache::get_counters() const
+{
+	return counters;
+}
+
+void GLStateCache::reset_counters()
+{
+	counters = {};
+}
@@ -1,31 +1,113 @@
 #include <glad/glad.h>
 
+#include <algorithm>
+#include <cstdint>
+
 #include "index_buffer.h"
+#include "gl_extensions.h"
+#include "gl_state_cache.h"
 #include "utility.h"
 
+static constexpr unsigned int MAX_SHORT_INDEX = 0xffff;
 
-IndexBuffer::IndexBuffer(const void *data, size_t size):renderer_id(0)
+static std::vector<IndexRange> split_index_ranges(std::span<const unsigned int> indices)
 {
-        GL_CALL(glGenBuffers(1, &renderer_id));
-        GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, renderer_id));
-        GL_CALL(glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-                                size * sizeof(unsigned int),
-                                data,
-                                GL_STATIC_DRAW));
+        std::vector<IndexRange> ranges;
+        IndexRange range{0, 0, 0};
+        unsigned int min_index = ~0u;
+        unsigned int max_index = 0;
+        for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+                const auto [low, high] = std::minmax({indices[t], indices[t + 1], indices[t + 2]});
+                if (range.count > 0 && std::max(max_index, high) - std::min(min_index, low) > MAX_SHORT_INDEX) {
+                        range.base_vertex = min_index;
+                        ranges.push_back(range);
+                        range = IndexRange{static_cast<unsigned int>(t), 0, 0};
+                        min_index = ~0u;
+                        max_index = 0;
+                }
+                min_index = std::min(min_index, low);
+                max_index = std::max(max_index, high);
+                range.count += 3;
+        }
+        if (range.count > 0) {
+                range.base_vertex = min_index;
+                ranges.push_back(range);
+        }
+        return ranges;
+}
+
+PackedIndices pack_indices(std::span<const unsigned int> indices, bool split_ranges)
+{
+        PackedIndices packed;
+        const unsigned int count = static_cast<unsigned int>(indices.size());
+        const unsigned int max_index = indices.empty() ? 0 : *std::max_element(indices.begin(), indices.end());
+
+        if (max_index <= MAX_SHORT_INDEX)
+                packed.ranges.push_back({0, count, 0});
+        else if (split_ranges) {
+                packed.ranges = split_index_ranges(indices);
+                if (packed.ranges.size() > MAX_INDEX_RANGES)
+                        packed.ranges.clear();
+        }
+
+        if (packed.ranges.empty()) {
+                packed.type = GL_UNSIGNED_INT;
+                packed.index_size = sizeof(unsigned int);
+                packed.ranges.push_back({0, count, 0});
+                return packed;
+        }
+
+        packed.type = GL_UNSIGNED_SHORT;
+        packed.index_size = sizeof(std::uint16_t);
+        packed.data.resize(indices.size() * sizeof(std::uint16_t));
+        auto *out = reinterpret_cast<std::uint16_t *>(packed.data.data());
+        for (const IndexRange &range : packed.ranges)
+                for (unsigned int i = range.first_index; i < range.first_index + range.count; ++i)
+                        out[i] = static_cast<std::uint16_t>(indices[i] - range.base_vertex);
+        return packed;
+}
+
+IndexBuffer::IndexBuffer(const void *data, size_t count):renderer_id(0), count(static_cast<unsigned int>(count))
+{
+        create(data, count * sizeof(unsigned int));
+}
 
+void IndexBuffer::create(const void *data, size_t size)
+{
+        const GLExtensions& ext = gl_extensions();
+        if (ext.direct_state_access) {
+                // binding an element array buffer would also attach it to the bound vertex array
+                GL_CALL(ext.CreateBuffers(1, &renderer_id));
+                GL_CALL(ext.NamedBufferStorage(renderer_id, size, data, 0));
+                return;
+        }
+        GL_CALL(glGenBuffers(1, &renderer_id));
+        GLStateCache::get().bind_buffer(GL_ELEMENT_ARRAY_BUFFER, renderer_id);
+        GL_CALL(glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, data, GL_STATIC_DRAW));
 }
 
 void IndexBuffer::bind() const
 {
-        GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, renderer_id));
+        GLStateCache::get().bind_buffer(GL_ELEMENT_ARRAY_BUFFER, renderer_id);
 }
 
 void IndexBuffer::unbind() const
 {
-        GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
+        GLStateCache::get().bind_buffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+unsigned int IndexBuffer::get_count() const
+{
+        return count;
+}
+
+unsigned int IndexBuffer::get_renderer_id() const
+{
+        return renderer_id;
 }
 
 IndexBuffer::~IndexBuffer()
 {
         GL_CALL(glDeleteBuffers(1, &renderer_id));
+        GLStateCache::get().on_buffer_deleted(renderer_id);
 }
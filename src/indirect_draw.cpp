@@ -0,0 +1,368 @@
+#include "indirect_draw.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <tuple>
+
+#include "gl_state_cache.h"
+#include "texture_upload.h"
+#include "utility.h"
+
+// returns the layer of texture in layers, adding it when new, 0 when there is no texture
+static GLuint find_layer(std::vector<unsigned int> &layers, const Mesh &mesh, const std::string &type)
+{
+	for (const MeshTexture &texture : mesh.textures) {
+		if (texture.type != type)
+			continue;
+		auto it = std::find(layers.begin(), layers.end(), texture.id);
+		if (it == layers.end())
+			it = layers.insert(layers.end(), texture.id);
+		return static_cast<GLuint>(it - layers.begin()) + 1;
+	}
+	return 0;
+}
+
+IndirectModelDraw::IndirectModelDraw(const Model &model):
+	command_buffer(0),
+	draw_data_buffer(0),
+	instance_buffer(0),
+	diffuse_array(0),
+	specular_array(0),
+	instance_count(0),
+	valid(false)
+{
+	// group by vertex array and index type, each group is one multi draw
+	std::vector<const Mesh *> meshes;
+	for (const Mesh &mesh : model.meshes) {
+		if (!mesh.arena || mesh.options.format == VertexFormat::Full) {
+			std::cerr << "IndirectModelDraw needs meshes in a compact format and shared geometry" << std::endl;
+			return;
+		}
+		meshes.push_back(&mesh);
+	}
+	std::stable_sort(meshes.begin(), meshes.end(), [](const Mesh *a, const Mesh *b) {
+		return std::tie(a->arena, a->indexType) < std::tie(b->arena, b->indexType);
+	});
+
+	std::vector<unsigned int> diffuse_textures;
+	std::vector<unsigned int> specular_textures;
+	std::vector<DrawData> draw_data;
+	for (const Mesh *mesh : meshes) {
+		if (batches.empty() || batches.back().arena != mesh->arena || batches.back().index_type != mesh->indexType)
+			batches.push_back({mesh->arena, mesh->indexType, commands.size(), 0});
+
+		DrawData data{};
+		data.position_offset = glm::vec4(mesh->positionOffset, 0.0f);
+		data.position_scale = glm::vec4(mesh->positionScale, 0.0f);
+		data.diffuse_layer = find_layer(diffuse_textures, *mesh, "texture_diffuse");
+		data.specular_layer = find_layer(specular_textures, *mesh, "texture_specular");
+
+		for (const IndexRange &range : mesh->indexRanges) {
+			DrawElementsIndirectCommand command{};
+			command.count = range.count;
+			command.first_index = static_cast<GLuint>(mesh->indexOffset / mesh->indexSize) + range.first_index;
+			command.base_vertex = static_cast<GLint>(mesh->baseVertex + range.base_vertex);
+			commands.push_back(command);
+			draw_data.push_back(data);
+			++batches.back().command_count;
+		}
+	}
+
+	diffuse_array = build_texture_array(diffuse_textures);
+	specular_array = build_texture_array(specular_textures);
+
+	GLStateCache& state = GLStateCache::get();
+	GL_CALL(glGenBuffers(1, &draw_data_buffer));
+	state.bind_buffer(GL_SHADER_STORAGE_BUFFER, draw_data_buffer);
+	GL_CALL(glBufferData(GL_SHADER_STORAGE_BUFFER, draw_data.size() * sizeof(DrawData), draw_data.data(), GL_STATIC_DRAW));
+	GL_CALL(glGenBuffers(1, &instance_buffer));
+	GL_CALL(glGenBuffers(1, &command_buffer));
+	valid = true;
+}
+
+IndirectModelDraw::~IndirectModelDraw()
+{
+	GLStateCache& state = GLStateCache::get();
+	for (unsigned int buffer : {command_buffer, draw_data_buffer, instance_buffer}) {
+		if (!buffer)
+			continue;
+		GL_CALL(glDeleteBuffers(1, &buffer));
+		state.on_buffer_deleted(buffer);
+	}
+	for (unsigned int texture : {diffuse_array, specular_array}) {
+		if (!texture)
+			continue;
+		GL_CALL(glDeleteTextures(1, &texture));
+		state.on_texture_deleted(texture);
+	}
+}
+
+// for the array bound to GL_TEXTURE_2D_ARRAY
+static void set_array_sampling()
+{
+	GL_CALL(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT));
+	GL_CALL(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT));
+	GL_CALL(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR));
+	GL_CALL(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+}
+
+// level 0 size, internal format and level count of a 2D texture
+struct SourceTexture {
+	GLint width;
+	GLint height;
+	GLint internal_format;
+	GLint levels;
+	bool compressed;
+};
+
+static SourceTexture query_source_texture(unsigned int texture)
+{
+	GLStateCache& state = GLStateCache::get();
+	state.bind_texture(GL_TEXTURE_2D, texture);
+	SourceTexture source{};
+	GLint compressed = GL_FALSE;
+	GL_CALL(glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &source.width));
+	GL_CALL(glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &source.height));
+	GL_CALL(glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &source.internal_format));
+	GL_CALL(glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED, &compressed));
+	source.compressed = compressed == GL_TRUE;
+
+	GLint immutable = GL_FALSE;
+	GL_CALL(glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_IMMUTABLE_FORMAT, &immutable));
+	if (immutable) {
+		GL_CALL(glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_IMMUTABLE_LEVELS, &source.levels));
+		return source;
+	}
+	GLint max_level = 0;
+	GL_CALL(glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, &max_level));
+	for (GLint width = source.width; width > 0 && source.levels <= max_level; ++source.levels)
+		GL_CALL(glGetTexLevelParameteriv(GL_TEXTURE_2D, source.levels + 1, GL_TEXTURE_WIDTH, &width));
+	return source;
+}
+
+// first level of a width x height chain that fits in MAX_LAYER_SIZE
+static GLint get_first_fitting_level(GLint width, GLint height)
+{
+	GLint level = 0;
+	while (std::max(width >> level, height >> level) > IndirectModelDraw::MAX_LAYER_SIZE)
+		++level;
+	return level;
+}
+
+// one 4x4 block of opaque white, for the untextured layer 0 of a compressed array
+static bool get_white_block(GLint internal_format, std::vector<unsigned char> &block)
+{
+	// both endpoints white and every index 0
+	static constexpr unsigned char bc1[8] = {0xFF, 0xFF, 0xFF, 0xFF, 0, 0, 0, 0};
+	static constexpr unsigned char bc4[8] = {0xFF, 0xFF, 0, 0, 0, 0, 0, 0};
+	// mode 6, every endpoint channel 0x7F with its p-bit set and every index 0
+	static constexpr unsigned char bc7[16] = {0xC0, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x01};
+
+	for (const BlockFormat format : {BlockFormat::BC1, BlockFormat::BC3, BlockFormat::BC5, BlockFormat::BC7}) {
+		if (static_cast<GLenum>(internal_format) != get_compressed_internal_format(format, false)
+			&& static_cast<GLenum>(internal_format) != get_compressed_internal_format(format, true))
+			continue;
+		switch (format) {
+		case BlockFormat::BC1: block.assign(bc1, bc1 + 8); break;
+		case BlockFormat::BC3: block.assign(bc4, bc4 + 8); block.insert(block.end(), bc1, bc1 + 8); break;
+		case BlockFormat::BC5: block.assign(bc4, bc4 + 8); block.insert(block.end(), bc4, bc4 + 8); break;
+		case BlockFormat::BC7: block.assign(bc7, bc7 + 16); break;
+		}
+		return true;
+	}
+	return false;
+}
+
+// Block compressed sources cannot be framebuffer attachments, so they are
+// not scaled by blitting. When they all share a format and size their
+// levels are copied as they are into a compressed array, starting at the
+// first one within MAX_LAYER_SIZE. 0 when the sources do not allow that.
+static unsigned int build_compressed_texture_array(const std::vector<unsigned int> &textures,
+	const std::vector<SourceTexture> &sources)
+{
+	const SourceTexture &first = sources.front();
+	GLint levels = first.levels;
+	for (const SourceTexture &source : sources) {
+		if (!source.compressed || source.internal_format != first.internal_format
+			|| source.width != first.width || source.height != first.height)
+			return 0;
+		levels = std::min(levels, source.levels);
+	}
+	std::vector<unsigned char> white_block;
+	if (!get_white_block(first.internal_format, white_block))
+		return 0;
+
+	const GLint first_level = std::min(get_first_fitting_level(first.width, first.height), levels - 1);
+	const GLint width = std::max(first.width >> first_level, 1);
+	const GLint height = std::max(first.height >> first_level, 1);
+	levels -= first_level;
+	const GLsizei layers = static_cast<GLsizei>(textures.size()) + 1;
+
+	unsigned int array = 0;
+	GL_CALL(glGenTextures(1, &array));
+	GLStateCache::get().bind_texture(GL_TEXTURE_2D_ARRAY, array);
+	GL_CALL(glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels, first.internal_format, width, height, layers));
+	for (GLint level = 0; level < levels; ++level) {
+		const GLint level_width = std::max(width >> level, 1);
+		const GLint level_height = std::max(height >> level, 1);
+		const size_t block_count = static_cast<size_t>((level_width + 3) / 4) * static_cast<size_t>((level_height + 3) / 4);
+		std::vector<unsigned char> white;
+		white.reserve(block_count * white_block.size());
+		for (size_t i = 0; i < block_count; ++i)
+			white.insert(white.end(), white_block.begin(), white_block.end());
+		GL_CALL(glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, 0, level_width, level_height, 1,
+			first.internal_format, static_cast<GLsizei>(white.size()), white.data()));
+
+		for (size_t i = 0; i < textures.size(); ++i) {
+			GL_CALL(glCopyImageSubData(textures[i], GL_TEXTURE_2D, first_level + level, 0, 0, 0,
+				array, GL_TEXTURE_2D_ARRAY, level, 0, 0, static_cast<GLint>(i + 1), level_width, level_height, 1));
+		}
+	}
+	set_array_sampling();
+	return array;
+}
+
+// an RGBA8 copy of a level of a compressed texture, decompressed by the driver
+static unsigned int decompress_texture(unsigned int texture, GLint level, GLint width, GLint height)
+{
+	GLStateCache& state = GLStateCache::get();
+	std::vector<unsigned char> pixels(static_cast<size_t>(width) * static_cast<size_t>(height) * 4);
+	state.bind_texture(GL_TEXTURE_2D, texture);
+	GL_CALL(glPixelStorei(GL_PACK_ALIGNMENT, 1));
+	GL_CALL(glGetTexImage(GL_TEXTURE_2D, level, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data()));
+	GL_CALL(glPixelStorei(GL_PACK_ALIGNMENT, 4));
+
+	unsigned int copy = 0;
+	GL_CALL(glGenTextures(1, &copy));
+	state.bind_texture(GL_TEXTURE_2D, copy);
+	GL_CALL(glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, width, height));
+	GL_CALL(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data()));
+	return copy;
+}
+
+unsigned int IndirectModelDraw::build_texture_array(const std::vector<unsigned int> &textures)
+{
+	GLStateCache& state = GLStateCache::get();
+	std::vector<SourceTexture> sources;
+	for (unsigned int texture : textures)
+		sources.push_back(query_source_texture(texture));
+	if (!textures.empty()) {
+		if (const unsigned int array = build_compressed_texture_array(textures, sources))
+			return array;
+	}
+
+	GLint width = 1;
+	GLint height = 1;
+	for (const SourceTexture &source : sources) {
+		width = std::max(width, source.width);
+		height = std::max(height, source.height);
+	}
+	width = std::min(width, MAX_LAYER_SIZE);
+	height = std::min(height, MAX_LAYER_SIZE);
+	const GLsizei levels = 1 + static_cast<GLsizei>(std::floor(std::log2(std::max(width, height))));
+	const GLsizei layers = static_cast<GLsizei>(textures.size()) + 1;
+
+	unsigned int array = 0;
+	GL_CALL(glGenTextures(1, &array));
+	state.bind_texture(GL_TEXTURE_2D_ARRAY, array);
+	GL_CALL(glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels, GL_RGBA8, width, height, layers));
+
+	// the copies scale on the GPU by blitting between framebuffers
+	unsigned int framebuffers[2] = {0, 0};
+	GL_CALL(glGenFramebuffers(2, framebuffers));
+	GL_CALL(glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffers[0]));
+	GL_CALL(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffers[1]));
+
+	static constexpr GLfloat white[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+	GL_CALL(glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, array, 0, 0));
+	GL_CALL(glClearBufferfv(GL_COLOR, 0, white));
+	for (size_t i = 0; i < textures.size(); ++i) {
+		// mixed formats or sizes: compressed sources are read back decompressed, from a level near the layer size
+		unsigned int source = textures[i];
+		GLint source_width = sources[i].width;
+		GLint source_height = sources[i].height;
+		if (sources[i].compressed) {
+			const GLint level = std::min(get_first_fitting_level(source_width, source_height), std::max(sources[i].levels - 1, 0));
+			source_width = std::max(source_width >> level, 1);
+			source_height = std::max(source_height >> level, 1);
+			source = decompress_texture(textures[i], level, source_width, source_height);
+		}
+
+		GL_CALL(glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, source, 0));
+		GL_CALL(glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, array, 0, static_cast<GLint>(i + 1)));
+		GL_CALL(glBlitFramebuffer(0, 0, source_width, source_height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_LINEAR));
+
+		if (source != textures[i]) {
+			GL_CALL(glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0));
+			GL_CALL(glDeleteTextures(1, &source));
+			state.on_texture_deleted(source);
+		}
+	}
+
+	GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+	GL_CALL(glDeleteFramebuffers(2, framebuffers));
+
+	state.bind_texture(GL_TEXTURE_2D_ARRAY, array);
+	GL_CALL(glGenerateMipmap(GL_TEXTURE_2D_ARRAY));
+	set_array_sampling();
+	return array;
+}
+
+void IndirectModelDraw::set_instances(const std::vector<glm::mat4> &transforms)
+{
+	if (!valid)
+		return;
+
+	GLStateCache& state = GLStateCache::get();
+	instance_count = static_cast<unsigned int>(transforms.size());
+	state.bind_buffer(GL_SHADER_STORAGE_BUFFER, instance_buffer);
+	GL_CALL(glBufferData(GL_SHADER_STORAGE_BUFFER, transforms.size() * sizeof(glm::mat4), transforms.data(), GL_DYNAMIC_DRAW));
+
+	// draw i covers draw ids [i * instance_count, (i + 1) * instance_count)
+	for (size_t i = 0; i < commands.size(); ++i) {
+		commands[i].instance_count = instance_count;
+		commands[i].base_instance = static_cast<GLuint>(i) * instance_count;
+	}
+	state.bind_buffer(GL_DRAW_INDIRECT_BUFFER, command_buffer);
+	GL_CALL(glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawElementsIndirectCommand), commands.data(), GL_DYNAMIC_DRAW));
+
+	for (const Batch &batch : batches)
+		batch.arena->reserve_draw_ids(commands.size() * instance_count);
+}
+
+void IndirectModelDraw::draw(const Shader &shader) const
+{
+	if (!valid || instance_count == 0)
+		return;
+
+	GLStateCache& state = GLStateCache::get();
+	state.bind_texture(DIFFUSE_UNIT, GL_TEXTURE_2D_ARRAY, diffuse_array);
+	state.bind_texture(SPECULAR_UNIT, GL_TEXTURE_2D_ARRAY, specular_array);
+	shader.set_int("material_diffuse", DIFFUSE_UNIT);
+	shader.set_int("material_specular", SPECULAR_UNIT);
+	shader.set_int("instances_per_draw", static_cast<int>(instance_count));
+
+	// the generic binding is left on the buffer, which keeps the cache right
+	state.bind_buffer(GL_SHADER_STORAGE_BUFFER, draw_data_buffer);
+	GL_CALL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_DATA_BINDING, draw_data_buffer));
+	state.bind_buffer(GL_SHADER_STORAGE_BUFFER, instance_buffer);
+	GL_CALL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCE_BINDING, instance_buffer));
+
+	state.bind_buffer(GL_DRAW_INDIRECT_BUFFER, command_buffer);
+	for (const Batch &batch : batches) {
+		batch.arena->bind();
+		const void *offset = (void*)(uintptr_t)(batch.first_command * sizeof(DrawElementsIndirectCommand));
+		GL_CALL(glMultiDrawElementsIndirect(GL_TRIANGLES, batch.index_type, offset, batch.command_count, 0));
+	}
+}
+
+bool IndirectModelDraw::is_valid() const
+{
+	return valid;
+}
+
+unsigned int IndirectModelDraw::get_command_count() const
+{
+	return static_cast<unsigned int>(commands.size());
+}
@@ -0,0 +1,106 @@
+#include "instance_buffer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+
+#include "gl_state_cache.h"
+#include "stream_buffer.h"
+#include "vertex_buffer_layout.h"
+#include "utility.h"
+
+InstanceBuffer::InstanceBuffer(size_t capacity): renderer_id(0), source_id(0), source_offset(0), count(0), capacity(std::max<size_t>(capacity, 1))
+{
+	GL_CALL(glGenBuffers(1, &renderer_id));
+	GLStateCache::get().bind_buffer(GL_ARRAY_BUFFER, renderer_id);
+	GL_CALL(glBufferData(GL_ARRAY_BUFFER, this->capacity * sizeof(Instance), nullptr, GL_STREAM_DRAW));
+	source_id = renderer_id;
+}
+
+InstanceBuffer::~InstanceBuffer()
+{
+	GL_CALL(glDeleteBuffers(1, &renderer_id));
+	GLStateCache::get().on_buffer_deleted(renderer_id);
+}
+
+void InstanceBuffer::set_instances(std::span<const glm::mat4> transforms, std::span<const glm::vec4> data)
+{
+	if (!data.empty() && data.size() != transforms.size()) {
+		std::cerr << "InstanceBuffer got " << data.size() << " data entries for "
+			<< transforms.size() << " transforms" << std::endl;
+		return;
+	}
+
+	count = transforms.size();
+	staging.resize(count);
+	for (size_t i = 0; i < count; ++i)
+		staging[i] = {transforms[i], data.empty() ? glm::vec4(0.0f) : data[i]};
+
+	// orphan the old storage so the driver does not wait for draws still reading it
+	GLStateCache::get().bind_buffer(GL_ARRAY_BUFFER, renderer_id);
+	if (count > capacity)
+		capacity = std::max(count, capacity * 2);
+	GL_CALL(glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(Instance), nullptr, GL_STREAM_DRAW));
+	GL_CALL(glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(Instance), staging.data()));
+	source_id = renderer_id;
+	source_offset = 0;
+}
+
+void InstanceBuffer::set_instances(StreamBuffer &stream, std::span<const glm::mat4> transforms, std::span<const glm::vec4> data)
+{
+	if (!data.empty() && data.size() != transforms.size()) {
+		std::cerr << "InstanceBuffer got " << data.size() << " data entries for "
+			<< transforms.size() << " transforms" << std::endl;
+		return;
+	}
+
+	const StreamBuffer::Allocation allocation = stream.allocate(transforms.size() * sizeof(Instance), alignof(Instance));
+	if (!allocation.data) {
+		count = 0;
+		return;
+	}
+
+	auto *instances = static_cast<Instance*>(allocation.data);
+	for (size_t i = 0; i < transforms.size(); ++i)
+		instances[i] = {transforms[i], data.empty() ? glm::vec4(0.0f) : data[i]};
+	stream.flush();
+
+	count = transforms.size();
+	source_id = stream.get_renderer_id();
+	source_offset = allocation.offset;
+}
+
+void InstanceBuffer::attach(unsigned int vertex_array) const
+{
+	GLStateCache& state = GLStateCache::get();
+	state.bind_vertex_array(vertex_array);
+	state.bind_buffer(GL_ARRAY_BUFFER, source_id);
+	// the mat4 takes MODEL_ATTRIBUTE and the three locations after it
+	static constexpr VertexBufferElement INSTANCE_ELEMENTS[] = {
+		VERTEX_ELEMENT(MODEL_ATTRIBUTE, Instance, model, float, AttributeKind::Float),
+		VERTEX_ELEMENT(DATA_ATTRIBUTE, Instance, data, float, AttributeKind::Float),
+	};
+	static_assert(INSTANCE_ELEMENTS[0].count == 16, "the model matrix has to fill four vec4 attributes");
+	VertexBufferLayout(INSTANCE_ELEMENTS, sizeof(Instance), 1).apply(source_offset);
+}
+
+void InstanceBuffer::draw_arrays(unsigned int vertex_array, GLenum mode, GLint first, GLsizei vertex_count) const
+{
+	if (count == 0)
+		return;
+	attach(vertex_array);
+	GL_CALL(glDrawArraysInstanced(mode, first, vertex_count, static_cast<GLsizei>(count)));
+}
+
+void InstanceBuffer::draw_elements(unsigned int vertex_array, GLenum mode, GLsizei index_count, GLenum type, const void *offset, GLint base_vertex) const
+{
+	if (count == 0)
+		return;
+	attach(vertex_array);
+	GL_CALL(glDrawElementsInstancedBaseVertex(mode, index_count, type, offset, static_cast<GLsizei>(count), base_vertex));
+}
+
+size_t InstanceBuffer::get_count() const
+{
+	return count;
+}
@@ -0,0 +1,139 @@
+#include "lz4_block.h"
+
+#include <cstdint>
+#include <cstring>
+
+// a block is a run of sequences: a token with the literal length in the
+// high and the match length - 4 in the low nibble, extra length bytes when
+// a nibble is 15, the literals, a 16 bit little endian offset back into the
+// output and extra match length bytes. The last sequence only has literals.
+static constexpr size_t MIN_MATCH = 4;
+// the last 5 bytes are always literals and no match starts in the last 12
+static constexpr size_t LAST_LITERALS = 5;
+static constexpr size_t MATCH_FIND_LIMIT = 12;
+static constexpr size_t MAX_OFFSET = 65535;
+static constexpr unsigned int HASH_BITS = 16;
+
+static std::uint32_t read_u32(const unsigned char *p)
+{
+	std::uint32_t value;
+	std::memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+static std::uint32_t hash_sequence(std::uint32_t sequence)
+{
+	return (sequence * 2654435761u) >> (32 - HASH_BITS);
+}
+
+static void write_length(std::vector<unsigned char> &out, size_t length)
+{
+	for (; length >= 255; length -= 255)
+		out.push_back(255);
+	out.push_back(static_cast<unsigned char>(length));
+}
+
+static void write_sequence(std::vector<unsigned char> &out, const unsigned char *literals, size_t literal_length,
+	size_t offset, size_t match_length)
+{
+	const size_t match_code = match_length >= MIN_MATCH ? match_length - MIN_MATCH : 0;
+	out.push_back(static_cast<unsigned char>((literal_length >= 15 ? 15 : literal_length) << 4
+		| (match_length == 0 ? 0 : match_code >= 15 ? 15 : match_code)));
+	if (literal_length >= 15)
+		write_length(out, literal_length - 15);
+	out.insert(out.end(), literals, literals + literal_length);
+	if (match_length == 0)
+		return;
+	out.push_back(static_cast<unsigned char>(offset));
+	out.push_back(static_cast<unsigned char>(offset >> 8));
+	if (match_code >= 15)
+		write_length(out, match_code - 15);
+}
+
+std::vector<unsigned char> lz4_compress(const unsigned char *data, size_t size)
+{
+	std::vector<unsigned char> out;
+	out.reserve(size + size / 255 + 16);
+	size_t anchor = 0;
+	if (size > MATCH_FIND_LIMIT) {
+		// position + 1 of the last sequence with each hash, 0 when there was none
+		std::vector<std::uint32_t> table(size_t(1) << HASH_BITS, 0);
+		const size_t match_end_limit = size - LAST_LITERALS;
+		size_t position = 0;
+		while (position < size - MATCH_FIND_LIMIT) {
+			const std::uint32_t sequence = read_u32(data + position);
+			std::uint32_t &slot = table[hash_sequence(sequence)];
+			const size_t candidate = slot;
+			slot = static_cast<std::uint32_t>(position + 1);
+			if (candidate == 0 || position - (candidate - 1) > MAX_OFFSET || read_u32(data + candidate - 1) != sequence) {
+				++position;
+				continue;
+			}
+
+			size_t match = candidate - 1;
+			size_t start = position;
+			while (start > anchor && match > 0 && data[start - 1] == data[match - 1]) {
+				--start;
+				--match;
+			}
+			size_t length = position - start + MIN_MATCH;
+			while (start + length < match_end_limit && data[start + length] == data[match + length])
+				++length;
+
+			write_sequence(out, data + anchor, start - anchor, start - match, length);
+			position = start + length;
+			anchor = position;
+		}
+	}
+	write_sequence(out, data + anchor, size - anchor, 0, 0);
+	return out;
+}
+
+bool lz4_decompress(const unsigned char *block, size_t block_size, unsigned char *out, size_t decompressed_size)
+{
+	const unsigned char *in = block;
+	const unsigned char *const in_end = block + block_size;
+	size_t written = 0;
+	const auto read_length = [&](size_t &length) {
+		unsigned char byte;
+		do {
+			if (in == in_end)
+				return false;
+			byte = *in++;
+			length += byte;
+		} while (byte == 255);
+		return true;
+	};
+
+	while (in < in_end) {
+		const unsigned char token = *in++;
+		size_t literal_length = token >> 4;
+		if (literal_length == 15 && !read_length(literal_length))
+			return false;
+		if (literal_length > static_cast<size_t>(in_end - in) || literal_length > decompressed_size - written)
+			return false;
+		if (literal_length > 0)
+			std::memcpy(out + written, in, literal_length);
+		in += literal_length;
+		written += literal_length;
+		// the last sequence ends after its literals
+		if (in == in_end)
+			break;
+
+		if (in_end - in < 2)
+			return false;
+		const size_t offset = size_t(in[0]) | size_t(in[1]) << 8;
+		in += 2;
+		size_t match_length = (token & 15u) + MIN_MATCH;
+		if ((token & 15u) == 15 && !read_length(match_length))
+			return false;
+		if (offset == 0 || offset > written || match_length > decompressed_size - written)
+			return false;
+		// the match may overlap what it writes, e.g. offset 1 repeats a byte
+		const unsigned char *match = out + written - offset;
+		for (size_t i = 0; i < match_length; ++i)
+			out[written + i] = match[i];
+		written += match_length;
+	}
+	return written == decompressed_size;
+}
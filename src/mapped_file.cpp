@@ -0,0 +1,166 @@
+#include "mapped_file.h"
+
+#include <algorithm>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept:
+	data(std::exchange(other.data, nullptr)),
+	size(std::exchange(other.size, 0)),
+	opened(std::exchange(other.opened, false))
+#ifdef _WIN32
+	, mapping(std::exchange(other.mapping, nullptr))
+#endif
+{
+}
+
+MappedFile& MappedFile::operator=(MappedFile &&other) noexcept
+{
+	if (this != &other) {
+		close();
+		data = std::exchange(other.data, nullptr);
+		size = std::exchange(other.size, 0);
+		opened = std::exchange(other.opened, false);
+#ifdef _WIN32
+		mapping = std::exchange(other.mapping, nullptr);
+#endif
+	}
+	return *this;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string &path, Access access)
+{
+	close();
+	// Windows takes the access pattern when the file is opened, there is no WillNeed
+	const DWORD flags = access == Access::Random ? FILE_FLAG_RANDOM_ACCESS : FILE_FLAG_SEQUENTIAL_SCAN;
+	const HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flags, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file, &file_size)) {
+		CloseHandle(file);
+		return false;
+	}
+	size = static_cast<size_t>(file_size.QuadPart);
+	if (size > 0) {
+		// the view keeps the file open, neither handle is needed once it exists
+		mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping)
+			data = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+		if (!data) {
+			if (mapping)
+				CloseHandle(mapping);
+			mapping = nullptr;
+			size = 0;
+			CloseHandle(file);
+			return false;
+		}
+	}
+	CloseHandle(file);
+	opened = true;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (data)
+		UnmapViewOfFile(data);
+	if (mapping)
+		CloseHandle(mapping);
+	data = nullptr;
+	mapping = nullptr;
+	size = 0;
+	opened = false;
+}
+
+void MappedFile::prefetch(size_t, size_t) const
+{
+}
+
+#else
+
+bool MappedFile::open(const std::string &path, Access access)
+{
+	close();
+	const int file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (file < 0)
+		return false;
+
+	struct stat status;
+	if (fstat(file, &status) != 0 || !S_ISREG(status.st_mode)) {
+		::close(file);
+		return false;
+	}
+	size = static_cast<size_t>(status.st_size);
+	if (size > 0) {
+		void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+		if (mapped == MAP_FAILED) {
+			::close(file);
+			size = 0;
+			return false;
+		}
+		data = static_cast<const unsigned char*>(mapped);
+		const int advice = access == Access::Random ? MADV_RANDOM : access == Access::WillNeed ? MADV_WILLNEED : MADV_SEQUENTIAL;
+		madvise(mapped, size, advice);
+	}
+	// the mapping keeps the file alive
+	::close(file);
+	opened = true;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (data)
+		munmap(const_cast<unsigned char*>(data), size);
+	data = nullptr;
+	size = 0;
+	opened = false;
+}
+
+void MappedFile::prefetch(size_t offset, size_t length) const
+{
+	if (offset >= size || length == 0)
+		return;
+	// madvise wants a page aligned start
+	static const auto page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	const size_t start = offset / page_size * page_size;
+	const size_t end = offset + std::min(length, size - offset);
+	madvise(const_cast<unsigned char*>(data) + start, end - start, MADV_WILLNEED);
+}
+
+#endif
+
+bool MappedFile::is_open() const
+{
+	return opened;
+}
+
+const unsigned char* MappedFile::get_data() const
+{
+	return data;
+}
+
+size_t MappedFile::get_size() const
+{
+	return size;
+}
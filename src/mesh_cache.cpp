@@ -0,0 +1,176 @@
+#include "mesh_cache.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+static constexpr char MESH_CACHE_MAGIC[8] = {'L', 'O', 'G', 'L', 'M', 'E', 'S', 'H'};
+
+static std::uint64_t align_up(std::uint64_t value, std::uint64_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+std::string get_mesh_cache_path(const std::string &asset_path)
+{
+    return asset_path + ".meshcache";
+}
+
+MeshView view_mesh(const MeshData &mesh)
+{
+    return {mesh.vertices, mesh.indices, mesh.textures};
+}
+
+bool map_mesh_cache(const std::string &cache_path,
+                    std::optional<std::uint64_t> source_hash,
+                    std::uint32_t import_flags,
+                    std::uint32_t pipeline_flags,
+                    AssetFile &file,
+                    std::vector<MeshView> &meshes)
+{
+    meshes.clear();
+    // every blob goes to the GPU right after, start reading all of it in
+    if (!VirtualFileSystem::get().open(cache_path, file, MappedFile::Access::WillNeed))
+        return false;
+
+    const std::uint64_t file_size = file.get_size();
+    if (file_size < sizeof(MeshCacheHeader)) {
+        file.close();
+        return false;
+    }
+
+    const unsigned char *data = file.get_data();
+    MeshCacheHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    const auto in_bounds = [&](std::uint64_t offset, std::uint64_t size) {
+        return offset <= file_size && size <= file_size - offset;
+    };
+    const std::uint64_t entries_size = std::uint64_t(header.mesh_count) * sizeof(MeshCacheEntry);
+    const std::uint64_t textures_size = std::uint64_t(header.texture_count) * sizeof(MeshCacheTexture);
+    if (std::memcmp(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic)) != 0
+        || header.version != MESH_CACHE_VERSION
+        || header.vertex_size != sizeof(Vertex)
+        || header.import_flags != import_flags
+        || (source_hash && (header.pipeline_flags != pipeline_flags || header.source_hash != *source_hash))
+        || header.file_size != file_size
+        || !in_bounds(sizeof(MeshCacheHeader), entries_size)
+        || !in_bounds(header.texture_table_offset, textures_size)
+        || !in_bounds(header.string_table_offset, header.string_table_size)) {
+        file.close();
+        return false;
+    }
+
+    // the tables are read in place, the header and entry sizes keep them 8 byte aligned
+    const auto entries = reinterpret_cast<const MeshCacheEntry *>(data + sizeof(MeshCacheHeader));
+    const auto textures = reinterpret_cast<const MeshCacheTexture *>(data + header.texture_table_offset);
+    const auto strings = reinterpret_cast<const char *>(data + header.string_table_offset);
+    const auto get_string = [&](std::uint32_t offset, std::uint32_t length, std::string &out) {
+        if (std::uint64_t(offset) + length > header.string_table_size)
+            return false;
+        out.assign(strings + offset, length);
+        return true;
+    };
+
+    meshes.resize(header.mesh_count);
+    for (std::uint32_t i = 0; i < header.mesh_count; ++i) {
+        const MeshCacheEntry &entry = entries[i];
+        MeshView &mesh = meshes[i];
+        bool valid = in_bounds(entry.vertex_offset, std::uint64_t(entry.vertex_count) * sizeof(Vertex))
+            && in_bounds(entry.index_offset, std::uint64_t(entry.index_count) * sizeof(unsigned int))
+            && entry.vertex_offset % alignof(Vertex) == 0 && entry.index_offset % alignof(unsigned int) == 0
+            && std::uint64_t(entry.first_texture) + entry.texture_count <= header.texture_count;
+
+        if (valid) {
+            mesh.vertices = {reinterpret_cast<const Vertex *>(data + entry.vertex_offset), entry.vertex_count};
+            mesh.indices = {reinterpret_cast<const unsigned int *>(data + entry.index_offset), entry.index_count};
+            mesh.textures.resize(entry.texture_count);
+        }
+        for (std::uint32_t t = 0; valid && t < entry.texture_count; ++t) {
+            const MeshCacheTexture &texture = textures[entry.first_texture + t];
+            mesh.textures[t].id = 0;
+            valid = get_string(texture.type_offset, texture.type_length, mesh.textures[t].type)
+                && get_string(texture.path_offset, texture.path_length, mesh.textures[t].path);
+        }
+        if (!valid) {
+            meshes.clear();
+            file.close();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool save_mesh_cache(const std::string &cache_path,
+                     std::uint64_t source_hash,
+                     std::uint32_t import_flags,
+                     std::uint32_t pipeline_flags,
+                     const std::vector<MeshData> &meshes)
+{
+    std::vector<MeshCacheEntry> entries(meshes.size());
+    std::vector<MeshCacheTexture> textures;
+    std::string strings;
+    const auto add_string = [&](const std::string &s, std::uint32_t &offset, std::uint32_t &length) {
+        offset = static_cast<std::uint32_t>(strings.size());
+        length = static_cast<std::uint32_t>(s.size());
+        strings += s;
+    };
+
+    for (size_t i = 0; i < meshes.size(); ++i) {
+        entries[i].vertex_count = static_cast<std::uint32_t>(meshes[i].vertices.size());
+        entries[i].index_count = static_cast<std::uint32_t>(meshes[i].indices.size());
+        entries[i].first_texture = static_cast<std::uint32_t>(textures.size());
+        entries[i].texture_count = static_cast<std::uint32_t>(meshes[i].textures.size());
+        for (const MeshTexture &texture : meshes[i].textures) {
+            MeshCacheTexture &t = textures.emplace_back();
+            add_string(texture.type, t.type_offset, t.type_length);
+            add_string(texture.path, t.path_offset, t.path_length);
+        }
+    }
+
+    MeshCacheHeader header{};
+    std::memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic));
+    header.version = MESH_CACHE_VERSION;
+    header.vertex_size = sizeof(Vertex);
+    header.import_flags = import_flags;
+    header.pipeline_flags = pipeline_flags;
+    header.mesh_count = static_cast<std::uint32_t>(meshes.size());
+    header.source_hash = source_hash;
+    header.texture_table_offset = sizeof(MeshCacheHeader) + entries.size() * sizeof(MeshCacheEntry);
+    header.texture_count = static_cast<std::uint32_t>(textures.size());
+    header.string_table_offset = header.texture_table_offset + textures.size() * sizeof(MeshCacheTexture);
+    header.string_table_size = static_cast<std::uint32_t>(strings.size());
+
+    std::uint64_t offset = header.string_table_offset + strings.size();
+    for (size_t i = 0; i < meshes.size(); ++i) {
+        offset = align_up(offset, MESH_CACHE_ALIGNMENT);
+        entries[i].vertex_offset = offset;
+        offset += meshes[i].vertices.size() * sizeof(Vertex);
+        offset = align_up(offset, MESH_CACHE_ALIGNMENT);
+        entries[i].index_offset = offset;
+        offset += meshes[i].indices.size() * sizeof(unsigned int);
+    }
+    header.file_size = offset;
+
+    std::ofstream file(cache_path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cerr << "Failed to write mesh cache " << cache_path << std::endl;
+        return false;
+    }
+
+    const auto write_at = [&](std::uint64_t at, const void *data, std::uint64_t size) {
+        static const char padding[MESH_CACHE_ALIGNMENT] = {};
+        const auto position = static_cast<std::uint64_t>(file.tellp());
+        file.write(padding, static_cast<std::streamsize>(at - position));
+        file.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+    };
+
+    write_at(0, &header, sizeof(header));
+    write_at(sizeof(header), entries.data(), entries.size() * sizeof(MeshCacheEntry));
+    write_at(header.texture_table_offset, textures.data(), textures.size() * sizeof(MeshCacheTexture));
+    write_at(header.string_table_offset, strings.data(), strings.size());
+    for (size_t i = 0; i < meshes.size(); ++i) {
+        write_at(entries[i].vertex_offset, meshes[i].vertices.data(), meshes[i].vertices.size() * sizeof(Vertex));
+        write_at(entries[i].index_offset, meshes[i].indices.data(), meshes[i].indices.size() * sizeof(unsigned int));
+    }
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,160 @@
+#include "mesh_import.h"
+
+#include <iostream>
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+#include "content_hash.h"
+#include "mesh_optimizer.h"
+#include "thread_pool.h"
+
+static constexpr unsigned int IMPORT_FLAGS = aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace;
+
+// collects the meshes of node and, recursively, of its children
+static void collect_meshes(const aiNode *node, const aiScene *scene, std::vector<const aiMesh *> &scene_meshes)
+{
+    // the node object only contains indices to index the actual objects in the scene.
+    // the scene contains all the data, node is just to keep stuff organized (like relations between nodes).
+    for (unsigned int i = 0; i < node->mNumMeshes; i++)
+        scene_meshes.push_back(scene->mMeshes[node->mMeshes[i]]);
+    for (unsigned int i = 0; i < node->mNumChildren; i++)
+        collect_meshes(node->mChildren[i], scene, scene_meshes);
+}
+
+// paths of all material textures of a given type, the texture ids are resolved by the caller
+static void add_material_textures(const aiMaterial *material, aiTextureType type, const std::string &type_name,
+                                  std::vector<MeshTexture> &textures)
+{
+    for (unsigned int i = 0; i < material->GetTextureCount(type); i++) {
+        aiString path;
+        material->GetTexture(type, i, &path);
+        textures.push_back({0, type_name, path.C_Str()});
+    }
+}
+
+// converts a single mesh, only reads the scene so several meshes can be converted concurrently
+static MeshData convert_mesh(const aiMesh *mesh, const aiScene *scene)
+{
+    // sized up front so the loops below do not reallocate
+    MeshData data;
+    data.vertices.resize(mesh->mNumVertices);
+
+    size_t index_count = 0;
+    for (unsigned int i = 0; i < mesh->mNumFaces; i++)
+        index_count += mesh->mFaces[i].mNumIndices;
+    data.indices.resize(index_count);
+
+    for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
+        Vertex &vertex = data.vertices[i];
+        vertex.Position = glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
+        if (mesh->HasNormals())
+            vertex.Normal = glm::vec3(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z);
+        // a vertex can contain up to 8 different texture coordinates, only the first set is used
+        if (mesh->mTextureCoords[0]) {
+            vertex.TexCoords = glm::vec2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y);
+            vertex.Tangent = glm::vec3(mesh->mTangents[i].x, mesh->mTangents[i].y, mesh->mTangents[i].z);
+            vertex.Bitangent = glm::vec3(mesh->mBitangents[i].x, mesh->mBitangents[i].y, mesh->mBitangents[i].z);
+        }
+        else
+            vertex.TexCoords = glm::vec2(0.0f, 0.0f);
+    }
+
+    for (unsigned int i = 0, k = 0; i < mesh->mNumFaces; i++) {
+        const aiFace &face = mesh->mFaces[i];
+        for (unsigned int j = 0; j < face.mNumIndices; j++)
+            data.indices[k++] = face.mIndices[j];
+    }
+
+    // the shaders name their samplers after the type, texture_diffuseN, texture_specularN and so on
+    const aiMaterial *material = scene->mMaterials[mesh->mMaterialIndex];
+    add_material_textures(material, aiTextureType_DIFFUSE, "texture_diffuse", data.textures);
+    add_material_textures(material, aiTextureType_SPECULAR, "texture_specular", data.textures);
+    add_material_textures(material, aiTextureType_HEIGHT, "texture_normal", data.textures);
+    add_material_textures(material, aiTextureType_AMBIENT, "texture_height", data.textures);
+    return data;
+}
+
+// prints the triangle weighted ACMR and ATVR of all meshes before and after optimization
+static void print_optimization_stats(const std::vector<MeshOptimizationStats> &stats)
+{
+    double triangles = 0.0;
+    VertexCacheStats before{};
+    VertexCacheStats after{};
+    for (const MeshOptimizationStats &mesh : stats) {
+        const float weight = static_cast<float>(mesh.triangle_count);
+        triangles += weight;
+        before.acmr += mesh.before.acmr * weight;
+        before.atvr += mesh.before.atvr * weight;
+        after.acmr += mesh.after.acmr * weight;
+        after.atvr += mesh.after.atvr * weight;
+    }
+    if (triangles == 0.0)
+        return;
+    std::cout << "mesh optimizer: ACMR " << before.acmr / triangles << " -> " << after.acmr / triangles
+              << ", ATVR " << before.atvr / triangles << " -> " << after.atvr / triangles << std::endl;
+}
+
+bool import_meshes(const std::string &path, bool optimize, std::vector<MeshData> &meshes)
+{
+    meshes.clear();
+    Assimp::Importer importer;
+    const aiScene *scene = importer.ReadFile(path, IMPORT_FLAGS);
+    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
+        std::cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << std::endl;
+        return false;
+    }
+
+    // gather the meshes of all nodes first, then convert them concurrently, each into its own slot
+    std::vector<const aiMesh *> scene_meshes;
+    collect_meshes(scene->mRootNode, scene, scene_meshes);
+    meshes.resize(scene_meshes.size());
+    std::vector<MeshOptimizationStats> optimization_stats(scene_meshes.size());
+    ThreadPool::shared().parallel_for(scene_meshes.size(), [&](size_t i) {
+        meshes[i] = convert_mesh(scene_meshes[i], scene);
+        if (optimize)
+            optimization_stats[i] = optimize_mesh(meshes[i]);
+    });
+    if (optimize)
+        print_optimization_stats(optimization_stats);
+    return true;
+}
+
+bool cook_meshes(const std::string &path, const std::string &cache_path, bool optimize)
+{
+    std::uint64_t source_hash = 0;
+    std::vector<MeshData> meshes;
+    if (!hash_file(path, source_hash) || !import_meshes(path, optimize, meshes))
+        return false;
+    return save_mesh_cache(cache_path, source_hash, IMPORT_FLAGS, optimize ? MESH_PIPELINE_OPTIMIZED : 0, meshes);
+}
+
+bool load_meshes(const std::string &path, bool optimize, LoadedMeshes &loaded)
+{
+    // the cache is keyed by the contents of the source file, the import flags and the post import steps
+    const std::uint32_t pipeline_flags = optimize ? MESH_PIPELINE_OPTIMIZED : 0;
+    // assimp only reads loose files, a source in an archive is never imported
+    const std::string source = VirtualFileSystem::get().resolve(path);
+    std::uint64_t source_hash = 0;
+    if (!hash_file(source, source_hash)) {
+        const std::string cache_path = get_mesh_cache_path(path);
+        loaded.from_cache = map_mesh_cache(cache_path, std::nullopt, IMPORT_FLAGS, pipeline_flags, loaded.cache, loaded.meshes);
+        if (!loaded.from_cache)
+            std::cout << "ERROR::MODEL:: neither " << path << " nor a cooked " << cache_path << " could be read" << std::endl;
+        return loaded.from_cache;
+    }
+
+    // next to the loose source, where it is written when stale
+    const std::string cache_path = get_mesh_cache_path(source);
+    loaded.from_cache = map_mesh_cache(cache_path, source_hash, IMPORT_FLAGS, pipeline_flags, loaded.cache, loaded.meshes);
+    if (loaded.from_cache)
+        return true;
+    if (!import_meshes(source, optimize, loaded.imported))
+        return false;
+    save_mesh_cache(cache_path, source_hash, IMPORT_FLAGS, pipeline_flags, loaded.imported);
+    loaded.meshes.reserve(loaded.imported.size());
+    for (const MeshData &mesh : loaded.imported)
+        loaded.meshes.push_back(view_mesh(mesh));
+    return true;
+}
@@ -0,0 +1,289 @@
+#include "mesh_optimizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// FIFO cache of vertex indices. A vertex is cached when fewer than size
+// misses happened since it was last loaded.
+class FifoCache {
+public:
+	FifoCache(size_t vertex_count, unsigned int size) :
+		timestamps(vertex_count, 0),
+		time(size + 1),
+		size(size)
+	{
+	}
+
+	// returns true on a miss
+	bool touch(unsigned int vertex)
+	{
+		if (time - timestamps[vertex] <= size)
+			return false;
+		timestamps[vertex] = time++;
+		return true;
+	}
+
+	void flush()
+	{
+		time += size + 1;
+	}
+
+private:
+	std::vector<unsigned int> timestamps;
+	unsigned int time;
+	unsigned int size;
+};
+
+unsigned int touch_triangle(FifoCache &cache, const unsigned int *triangle)
+{
+	return cache.touch(triangle[0]) + cache.touch(triangle[1]) + cache.touch(triangle[2]);
+}
+
+// triangles adjacent to every vertex in a flat array
+struct Adjacency {
+	std::vector<unsigned int> offsets;
+	std::vector<unsigned int> triangles;
+};
+
+Adjacency build_adjacency(const std::vector<unsigned int> &indices, size_t vertex_count)
+{
+	Adjacency adjacency;
+	adjacency.offsets.assign(vertex_count + 1, 0);
+	for (unsigned int index : indices)
+		++adjacency.offsets[index + 1];
+	for (size_t v = 0; v < vertex_count; ++v)
+		adjacency.offsets[v + 1] += adjacency.offsets[v];
+
+	adjacency.triangles.resize(indices.size());
+	std::vector<unsigned int> fill(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+	for (size_t i = 0; i < indices.size(); ++i)
+		adjacency.triangles[fill[indices[i]]++] = static_cast<unsigned int>(i / 3);
+	return adjacency;
+}
+
+}
+
+VertexCacheStats analyze_vertex_cache(const std::vector<unsigned int> &indices, size_t vertex_count, unsigned int cache_size)
+{
+	FifoCache cache(vertex_count, cache_size);
+	std::vector<bool> referenced(vertex_count, false);
+	size_t misses = 0;
+	size_t unique_vertices = 0;
+	for (unsigned int index : indices) {
+		misses += cache.touch(index);
+		if (!referenced[index]) {
+			referenced[index] = true;
+			++unique_vertices;
+		}
+	}
+
+	const size_t triangle_count = indices.size() / 3;
+	VertexCacheStats stats{};
+	stats.acmr = triangle_count ? static_cast<float>(misses) / triangle_count : 0.0f;
+	stats.atvr = unique_vertices ? static_cast<float>(misses) / unique_vertices : 0.0f;
+	return stats;
+}
+
+void optimize_vertex_cache(std::vector<unsigned int> &indices, size_t vertex_count, unsigned int cache_size)
+{
+	const size_t triangle_count = indices.size() / 3;
+	if (triangle_count == 0)
+		return;
+
+	const Adjacency adjacency = build_adjacency(indices, vertex_count);
+	std::vector<unsigned int> live_triangles(vertex_count);
+	for (size_t v = 0; v < vertex_count; ++v)
+		live_triangles[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+
+	std::vector<unsigned int> cache_time(vertex_count, 0);
+	std::vector<bool> emitted(triangle_count, false);
+	std::vector<unsigned int> dead_end_stack;
+	std::vector<unsigned int> candidates;
+	std::vector<unsigned int> result;
+	result.reserve(indices.size());
+
+	unsigned int time = cache_size + 1;
+	size_t cursor = 0;
+	long fanning_vertex = 0;
+	while (fanning_vertex >= 0) {
+		candidates.clear();
+		const unsigned int f = static_cast<unsigned int>(fanning_vertex);
+		for (unsigned int a = adjacency.offsets[f]; a < adjacency.offsets[f + 1]; ++a) {
+			const unsigned int triangle = adjacency.triangles[a];
+			if (emitted[triangle])
+				continue;
+			for (int c = 0; c < 3; ++c) {
+				const unsigned int v = indices[triangle * 3 + c];
+				result.push_back(v);
+				dead_end_stack.push_back(v);
+				candidates.push_back(v);
+				--live_triangles[v];
+				if (time - cache_time[v] > cache_size)
+					cache_time[v] = time++;
+			}
+			emitted[triangle] = true;
+		}
+
+		// prefer the candidate that stays in the cache while its remaining triangles are fanned
+		fanning_vertex = -1;
+		int best_priority = -1;
+		for (unsigned int v : candidates) {
+			if (live_triangles[v] == 0)
+				continue;
+			int priority = 0;
+			if (time - cache_time[v] + 2 * live_triangles[v] <= cache_size)
+				priority = static_cast<int>(time - cache_time[v]);
+			if (priority > best_priority) {
+				best_priority = priority;
+				fanning_vertex = v;
+			}
+		}
+
+		// dead end, fall back to recently used vertices and then to input order
+		while (fanning_vertex < 0 && !dead_end_stack.empty()) {
+			const unsigned int v = dead_end_stack.back();
+			dead_end_stack.pop_back();
+			if (live_triangles[v] > 0)
+				fanning_vertex = v;
+		}
+		while (fanning_vertex < 0 && cursor < vertex_count) {
+			if (live_triangles[cursor] > 0)
+				fanning_vertex = static_cast<long>(cursor);
+			++cursor;
+		}
+	}
+	indices = std::move(result);
+}
+
+void optimize_overdraw(std::vector<unsigned int> &indices, const std::vector<Vertex> &vertices, float threshold, unsigned int cache_size)
+{
+	const size_t triangle_count = indices.size() / 3;
+	if (triangle_count == 0)
+		return;
+
+	// hard boundaries: triangles missing all three vertices start a new strip of the cache order;
+	// the first cluster always starts at 0, even when the first triangle is degenerate and misses fewer
+	std::vector<size_t> hard_boundaries{0};
+	{
+		FifoCache cache(vertices.size(), cache_size);
+		for (size_t t = 0; t < triangle_count; ++t)
+			if (touch_triangle(cache, &indices[t * 3]) == 3 && t != hard_boundaries.back())
+				hard_boundaries.push_back(t);
+	}
+	hard_boundaries.push_back(triangle_count);
+
+	// soft boundaries: split a hard cluster wherever restarting the cache there
+	// keeps the ACMR within threshold of the cluster's own
+	std::vector<size_t> clusters;
+	for (size_t h = 0; h + 1 < hard_boundaries.size(); ++h) {
+		const size_t begin = hard_boundaries[h];
+		const size_t end = hard_boundaries[h + 1];
+
+		FifoCache cache(vertices.size(), cache_size);
+		size_t cluster_misses = 0;
+		for (size_t t = begin; t < end; ++t)
+			cluster_misses += touch_triangle(cache, &indices[t * 3]);
+		const float cluster_threshold = threshold * static_cast<float>(cluster_misses) / static_cast<float>(end - begin);
+
+		clusters.push_back(begin);
+		cache.flush();
+		size_t misses = 0;
+		size_t count = 0;
+		for (size_t t = begin; t < end; ++t) {
+			misses += touch_triangle(cache, &indices[t * 3]);
+			++count;
+			if (t + 1 < end && static_cast<float>(misses) / static_cast<float>(count) <= cluster_threshold) {
+				clusters.push_back(t + 1);
+				cache.flush();
+				misses = 0;
+				count = 0;
+			}
+		}
+	}
+	clusters.push_back(triangle_count);
+
+	struct Cluster {
+		size_t begin;
+		size_t end;
+		glm::vec3 centroid;
+		glm::vec3 normal;
+		float sort_key;
+	};
+
+	std::vector<Cluster> sorted(clusters.size() - 1);
+	glm::vec3 mesh_centroid(0.0f);
+	float mesh_area = 0.0f;
+	for (size_t c = 0; c + 1 < clusters.size(); ++c) {
+		Cluster &cluster = sorted[c];
+		cluster.begin = clusters[c];
+		cluster.end = clusters[c + 1];
+
+		// area weighted centroid and normal
+		glm::vec3 centroid(0.0f);
+		glm::vec3 normal(0.0f);
+		float area = 0.0f;
+		for (size_t t = cluster.begin; t < cluster.end; ++t) {
+			const glm::vec3 &p0 = vertices[indices[t * 3]].Position;
+			const glm::vec3 &p1 = vertices[indices[t * 3 + 1]].Position;
+			const glm::vec3 &p2 = vertices[indices[t * 3 + 2]].Position;
+			const glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+			const float triangle_area = glm::length(n);
+			centroid = centroid + (p0 + p1 + p2) * (triangle_area / 3.0f);
+			normal = normal + n;
+			area += triangle_area;
+		}
+		cluster.centroid = area > 0.0f ? centroid * (1.0f / area) : vertices[indices[cluster.begin * 3]].Position;
+		const float normal_length = glm::length(normal);
+		cluster.normal = normal_length > 0.0f ? normal * (1.0f / normal_length) : glm::vec3(0.0f);
+
+		mesh_centroid = mesh_centroid + centroid;
+		mesh_area += area;
+	}
+	if (mesh_area > 0.0f)
+		mesh_centroid = mesh_centroid * (1.0f / mesh_area);
+
+	// clusters facing away from the center occlude the ones facing inward, draw them first
+	for (Cluster &cluster : sorted)
+		cluster.sort_key = glm::dot(cluster.centroid - mesh_centroid, cluster.normal);
+	std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster &a, const Cluster &b) {
+		return a.sort_key > b.sort_key;
+	});
+
+	std::vector<unsigned int> result;
+	result.reserve(indices.size());
+	for (const Cluster &cluster : sorted)
+		result.insert(result.end(), indices.begin() + cluster.begin * 3, indices.begin() + cluster.end * 3);
+	indices = std::move(result);
+}
+
+void optimize_vertex_fetch(std::vector<unsigned int> &indices, std::vector<Vertex> &vertices)
+{
+	constexpr unsigned int UNUSED = ~0u;
+	std::vector<unsigned int> remap(vertices.size(), UNUSED);
+	std::vector<Vertex> reordered;
+	reordered.reserve(vertices.size());
+	for (unsigned int &index : indices) {
+		if (remap[index] == UNUSED) {
+			remap[index] = static_cast<unsigned int>(reordered.size());
+			reordered.push_back(vertices[index]);
+		}
+		index = remap[index];
+	}
+	vertices = std::move(reordered);
+}
+
+MeshOptimizationStats optimize_mesh(MeshData &mesh)
+{
+	MeshOptimizationStats stats{};
+	stats.triangle_count = mesh.indices.size() / 3;
+	stats.before = analyze_vertex_cache(mesh.indices, mesh.vertices.size());
+
+	optimize_vertex_cache(mesh.indices, mesh.vertices.size());
+	optimize_overdraw(mesh.indices, mesh.vertices);
+	optimize_vertex_fetch(mesh.indices, mesh.vertices);
+
+	stats.after = analyze_vertex_cache(mesh.indices, mesh.vertices.size());
+	return stats;
+}
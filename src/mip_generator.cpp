@@ -0,0 +1,162 @@
+#include "mip_generator.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MIP_GENERATOR_SSE2 1
+#endif
+
+// linear values are looked up at this resolution when converting back to sRGB
+static constexpr int LINEAR_TO_SRGB_STEPS = 4096;
+
+static const std::array<float, 256>& get_srgb_to_linear()
+{
+	static const std::array<float, 256> table = [] {
+		std::array<float, 256> t{};
+		for (int i = 0; i < 256; ++i) {
+			const float c = i / 255.0f;
+			t[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+		}
+		return t;
+	}();
+	return table;
+}
+
+static const std::array<unsigned char, LINEAR_TO_SRGB_STEPS + 1>& get_linear_to_srgb()
+{
+	static const std::array<unsigned char, LINEAR_TO_SRGB_STEPS + 1> table = [] {
+		std::array<unsigned char, LINEAR_TO_SRGB_STEPS + 1> t{};
+		for (int i = 0; i <= LINEAR_TO_SRGB_STEPS; ++i) {
+			const float l = static_cast<float>(i) / LINEAR_TO_SRGB_STEPS;
+			const float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+			t[i] = static_cast<unsigned char>(std::clamp(c * 255.0f + 0.5f, 0.0f, 255.0f));
+		}
+		return t;
+	}();
+	return table;
+}
+
+// sums[i] = a[i] + b[i] for count bytes, the vertical half of the box filter
+static void add_rows(const unsigned char *a, const unsigned char *b, std::uint16_t *sums, size_t count)
+{
+	size_t i = 0;
+#ifdef MIP_GENERATOR_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	for (; i + 16 <= count; i += 16) {
+		const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+		const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+		const __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(va, zero), _mm_unpacklo_epi8(vb, zero));
+		const __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(va, zero), _mm_unpackhi_epi8(vb, zero));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(sums + i), lo);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(sums + i + 8), hi);
+	}
+#endif
+	for (; i < count; ++i)
+		sums[i] = static_cast<std::uint16_t>(a[i] + b[i]);
+}
+
+// horizontal half, averages neighbouring pixels of the row sums
+static void average_columns(const std::uint16_t *sums, int src_width, unsigned char *dst, int dst_width, int channels)
+{
+#ifdef MIP_GENERATOR_SSE2
+	if (channels == 4 && src_width >= 2) {
+		// two destination pixels from the sums of four source pixels per step
+		const __m128i two = _mm_set1_epi16(2);
+		int x = 0;
+		for (; x + 2 <= dst_width; x += 2) {
+			const __m128i left = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sums + x * 8));
+			const __m128i right = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sums + x * 8 + 8));
+			const __m128i first = _mm_add_epi16(left, _mm_srli_si128(left, 8));
+			const __m128i second = _mm_add_epi16(right, _mm_srli_si128(right, 8));
+			__m128i result = _mm_unpacklo_epi64(first, second);
+			result = _mm_srli_epi16(_mm_add_epi16(result, two), 2);
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(dst + x * 4), _mm_packus_epi16(result, result));
+		}
+		for (; x < dst_width; ++x) {
+			for (int k = 0; k < 4; ++k)
+				dst[x * 4 + k] = static_cast<unsigned char>((sums[x * 8 + k] + sums[x * 8 + 4 + k] + 2) >> 2);
+		}
+		return;
+	}
+#endif
+	for (int x = 0; x < dst_width; ++x) {
+		const int x0 = 2 * x;
+		const int x1 = std::min(2 * x + 1, src_width - 1);
+		for (int k = 0; k < channels; ++k)
+			dst[x * channels + k] = static_cast<unsigned char>((sums[x0 * channels + k] + sums[x1 * channels + k] + 2) >> 2);
+	}
+}
+
+static void downsample(const unsigned char *src, int src_width, int src_height,
+                       unsigned char *dst, int dst_width, int dst_height, int channels,
+                       std::vector<std::uint16_t> &sums)
+{
+	const size_t row_size = static_cast<size_t>(src_width) * channels;
+	sums.resize(row_size);
+	for (int y = 0; y < dst_height; ++y) {
+		const unsigned char *row0 = src + static_cast<size_t>(2 * y) * row_size;
+		const unsigned char *row1 = src + static_cast<size_t>(std::min(2 * y + 1, src_height - 1)) * row_size;
+		add_rows(row0, row1, sums.data(), row_size);
+		average_columns(sums.data(), src_width, dst + static_cast<size_t>(y) * dst_width * channels, dst_width, channels);
+	}
+}
+
+static void downsample_srgb(const unsigned char *src, int src_width, int src_height,
+                            unsigned char *dst, int dst_width, int dst_height, int channels)
+{
+	const std::array<float, 256> &to_linear = get_srgb_to_linear();
+	const auto &to_srgb = get_linear_to_srgb();
+	const size_t row_size = static_cast<size_t>(src_width) * channels;
+	for (int y = 0; y < dst_height; ++y) {
+		const unsigned char *row0 = src + static_cast<size_t>(2 * y) * row_size;
+		const unsigned char *row1 = src + static_cast<size_t>(std::min(2 * y + 1, src_height - 1)) * row_size;
+		unsigned char *out = dst + static_cast<size_t>(y) * dst_width * channels;
+		for (int x = 0; x < dst_width; ++x) {
+			const int x0 = 2 * x * channels;
+			const int x1 = std::min(2 * x + 1, src_width - 1) * channels;
+			for (int k = 0; k < 3; ++k) {
+				const float sum = to_linear[row0[x0 + k]] + to_linear[row0[x1 + k]] + to_linear[row1[x0 + k]] + to_linear[row1[x1 + k]];
+				out[x * channels + k] = to_srgb[static_cast<int>(sum * (LINEAR_TO_SRGB_STEPS / 4.0f) + 0.5f)];
+			}
+			if (channels == 4)
+				out[x * 4 + 3] = static_cast<unsigned char>((row0[x0 + 3] + row0[x1 + 3] + row1[x0 + 3] + row1[x1 + 3] + 2) >> 2);
+		}
+	}
+}
+
+MipChain generate_mip_chain(const unsigned char *pixels, int width, int height, int channels, bool srgb)
+{
+	MipChain chain;
+	chain.channels = channels;
+	chain.srgb = srgb;
+
+	size_t size = 0;
+	for (int w = width, h = height;; w = std::max(w / 2, 1), h = std::max(h / 2, 1)) {
+		chain.levels.push_back({w, h, size});
+		size += static_cast<size_t>(w) * h * channels;
+		if (w == 1 && h == 1)
+			break;
+	}
+
+	chain.data.resize(size);
+	std::memcpy(chain.data.data(), pixels, static_cast<size_t>(width) * height * channels);
+
+	const bool linearize = srgb && channels >= 3;
+	std::vector<std::uint16_t> sums;
+	for (size_t i = 1; i < chain.levels.size(); ++i) {
+		const MipLevel &parent = chain.levels[i - 1];
+		const MipLevel &level = chain.levels[i];
+		const unsigned char *src = chain.data.data() + parent.offset;
+		unsigned char *dst = chain.data.data() + level.offset;
+		if (linearize)
+			downsample_srgb(src, parent.width, parent.height, dst, level.width, level.height, channels);
+		else
+			downsample(src, parent.width, parent.height, dst, level.width, level.height, channels, sums);
+	}
+	return chain;
+}
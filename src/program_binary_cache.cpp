@@ -0,0 +1,141 @@
+#include "program_binary_cache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "content_hash.h"
+#include "gl_extensions.h"
+#include "mapped_file.h"
+#include "utility.h"
+
+namespace fs = std::filesystem;
+
+static constexpr char PROGRAM_BINARY_MAGIC[8] = {'L', 'O', 'G', 'L', 'P', 'R', 'O', 'G'};
+
+static_assert(sizeof(ProgramBinaryHeader) == 32);
+
+// what the context was created on, queried once; programs are only created on the GL thread.
+// formats stays empty when the context has no program binaries, which turns the cache off
+struct ProgramBinaryDriver {
+	std::uint64_t hash = 0;
+	std::vector<GLint> formats;
+};
+
+static const ProgramBinaryDriver& get_driver()
+{
+	static const ProgramBinaryDriver driver = [] {
+		ProgramBinaryDriver result;
+		result.hash = hash_bytes(&PROGRAM_BINARY_CACHE_VERSION, sizeof(PROGRAM_BINARY_CACHE_VERSION));
+		for (const GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+			const auto value = reinterpret_cast<const char*>(glGetString(name));
+			const std::string_view text = value ? value : "";
+			result.hash = hash_bytes(text.data(), text.size() + 1, result.hash);
+		}
+
+		if (!gl_extensions().get_program_binary)
+			return result;
+		GLint count = 0;
+		GL_CALL(glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &count));
+		result.formats.resize(static_cast<size_t>(std::max(count, 0)));
+		if (count > 0)
+			GL_CALL(glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, result.formats.data()));
+		return result;
+	}();
+	return driver;
+}
+
+static std::string get_program_binary_path(std::uint64_t key)
+{
+	char name[21];
+	std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+	return (fs::path(PROGRAM_BINARY_CACHE_DIRECTORY) / name).string();
+}
+
+std::uint64_t get_program_binary_key(std::initializer_list<std::string_view> sources)
+{
+	std::uint64_t hash = get_driver().hash;
+	for (const std::string_view source : sources) {
+		// the length keeps "ab" + "c" apart from "a" + "bc"
+		const std::uint64_t size = source.size();
+		hash = hash_bytes(&size, sizeof(size), hash);
+		hash = hash_bytes(source.data(), source.size(), hash);
+	}
+	return hash;
+}
+
+unsigned int load_program_binary(std::uint64_t key)
+{
+	const ProgramBinaryDriver &driver = get_driver();
+	if (driver.formats.empty())
+		return 0;
+
+	MappedFile file;
+	if (!file.open(get_program_binary_path(key), MappedFile::Access::Sequential))
+		return 0;
+	ProgramBinaryHeader header;
+	if (file.get_size() < sizeof(header))
+		return 0;
+	std::memcpy(&header, file.get_data(), sizeof(header));
+	if (std::memcmp(header.magic, PROGRAM_BINARY_MAGIC, sizeof(header.magic)) != 0
+		|| header.version != PROGRAM_BINARY_CACHE_VERSION
+		|| header.key != key
+		|| header.size != file.get_size() - sizeof(header)
+		|| std::find(driver.formats.begin(), driver.formats.end(), static_cast<GLint>(header.format)) == driver.formats.end())
+		return 0;
+
+	const unsigned int program = glCreateProgram();
+	GL_CALL(gl_extensions().ProgramBinary(program, header.format, file.get_data() + sizeof(header), static_cast<GLsizei>(header.size)));
+	// a driver update may reject binaries of the same format, that is not an error
+	int success = 0;
+	GL_CALL(glGetProgramiv(program, GL_LINK_STATUS, &success));
+	if (!success) {
+		GL_CALL(glDeleteProgram(program));
+		return 0;
+	}
+	return program;
+}
+
+bool save_program_binary(std::uint64_t key, unsigned int program)
+{
+	if (get_driver().formats.empty())
+		return false;
+
+	int length = 0;
+	GL_CALL(glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length));
+	if (length <= 0)
+		return false;
+	std::vector<char> binary(static_cast<size_t>(length));
+	GLsizei written = 0;
+	GLenum format = 0;
+	GL_CALL(gl_extensions().GetProgramBinary(program, length, &written, &format, binary.data()));
+	if (written <= 0)
+		return false;
+
+	ProgramBinaryHeader header{};
+	std::memcpy(header.magic, PROGRAM_BINARY_MAGIC, sizeof(header.magic));
+	header.version = PROGRAM_BINARY_CACHE_VERSION;
+	header.format = format;
+	header.key = key;
+	header.size = static_cast<std::uint64_t>(written);
+
+	const std::string path = get_program_binary_path(key);
+	std::error_code error;
+	fs::create_directories(PROGRAM_BINARY_CACHE_DIRECTORY, error);
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(binary.data(), written);
+	if (!file) {
+		std::cerr << "Failed to write program binary " << path << std::endl;
+		return false;
+	}
+	return true;
+}
@@ -2,13 +2,19 @@
 // Created by vocasle on 11/27/21.
 //
 
+#include <iostream>
 #include <string>
+#include <vector>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <glad/glad.h>
 
 #include "shader.h"
+#include "gl_extensions.h"
+#include "gl_state_cache.h"
+#include "mapped_file.h"
+#include "program_binary_cache.h"
 #include "utility.h"
 
 struct ShaderSource {
@@ -18,21 +24,21 @@ struct ShaderSource {
     std::string fragment_file_path;
 };
 
+// the whole file, copied once out of a mapping of it
+static std::string read_shader_file(const std::string& path)
+{
+    MappedFile file;
+    if (!file.open(path, MappedFile::Access::Sequential)) {
+        std::cerr << "ERROR::SHADER::FILE_NOT_READ " << path << std::endl;
+        return {};
+    }
+    return std::string(reinterpret_cast<const char*>(file.get_data()), file.get_size());
+}
+
 static ShaderSource load_shader_source(const std::string& vert_path,
                                         const std::string& frag_path)
 {
-    std::ifstream vert_file(vert_path);
-    std::ifstream frag_file(frag_path);
-    std::string line;
-    std::ostringstream ss[2];
-
-    while (std::getline(vert_file, line))
-        ss[0] << line << '\n';
-
-    while (std::getline(frag_file, line))
-        ss[1] << line << '\n';
-
-    return {ss[0].str(), ss[1].str(), vert_path, frag_path};
+    return {read_shader_file(vert_path), read_shader_file(frag_path), vert_path, frag_path};
 }
 
 unsigned int compile_shader(GLenum shader_type, const std::string& source,
@@ -59,6 +65,9 @@ unsigned int compile_shader(GLenum shader_type, const std::string& source,
 unsigned int compile_program(unsigned int vertex_shader, unsigned int fragment_shader)
 {
     unsigned int program = glCreateProgram();
+    // lets save_program_binary fetch the linked program
+    if (gl_extensions().get_program_binary)
+        GL_CALL(gl_extensions().ProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
     GL_CALL(glAttachShader(program, vertex_shader));
     GL_CALL(glAttachShader(program, fragment_shader));
     GL_CALL(glLinkProgram(program));
@@ -76,60 +85,179 @@ unsigned int compile_program(unsigned int vertex_shader, unsigned int fragment_s
     return program;
 }
 
-static unsigned int create_program(const ShaderSource& ss)
+static unsigned int compile_sources(const ShaderSource& ss)
 {
     return compile_program(compile_shader(GL_VERTEX_SHADER, ss.vertex, ss.vertex_file_path),
             compile_shader(GL_FRAGMENT_SHADER, ss.fragment, ss.fragment_file_path));
 }
 
+// the cached binary of these sources when the driver takes it, compiled and cached otherwise
+static unsigned int create_program(const ShaderSource& ss)
+{
+    if (ss.vertex.empty() || ss.fragment.empty())
+        return compile_sources(ss);
+
+    const std::uint64_t key = get_program_binary_key({ss.vertex, ss.fragment});
+    if (const unsigned int program = load_program_binary(key))
+        return program;
+
+    const unsigned int program = compile_sources(ss);
+    if (program)
+        save_program_binary(key, program);
+    return program;
+}
+
 Shader::Shader(const std::string& vertex_path, const std::string& pixel_path)
 {
     program_id = create_program(load_shader_source(vertex_path, pixel_path));
+    cache_uniforms();
+}
+
+void Shader::cache_uniforms()
+{
+    if (!program_id)
+        return;
+
+    int uniform_count = 0;
+    int max_name_length = 0;
+    GL_CALL(glGetProgramiv(program_id, GL_ACTIVE_UNIFORMS, &uniform_count));
+    GL_CALL(glGetProgramiv(program_id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_name_length));
+
+    std::vector<UniformSlot> active;
+    std::vector<char> name(max_name_length + 1);
+    for (int i = 0; i < uniform_count; ++i) {
+        int length = 0;
+        int size = 0;
+        GLenum type = 0;
+        GL_CALL(glGetActiveUniform(program_id, i, static_cast<int>(name.size()), &length, &size, &type, name.data()));
+        const int location = glGetUniformLocation(program_id, name.data());
+        // members of uniform blocks have no location
+        if (location < 0)
+            continue;
+        const std::string_view uniform_name(name.data(), length);
+        active.push_back({hash_uniform_name(uniform_name), location, false});
+
+        // arrays of basic types are reported once as "name[0]", register "name" and every element as well
+        if (size > 1 && uniform_name.ends_with("[0]")) {
+            const std::string base(uniform_name.substr(0, uniform_name.size() - 3));
+            active.push_back({hash_uniform_name(base), location, false});
+            for (int j = 1; j < size; ++j) {
+                const std::string element = base + '[' + std::to_string(j) + ']';
+                const int element_location = glGetUniformLocation(program_id, element.c_str());
+                if (element_location >= 0)
+                    active.push_back({hash_uniform_name(element), element_location, false});
+            }
+        }
+    }
+
+    size_t capacity = 8;
+    while (capacity < active.size() * 2)
+        capacity *= 2;
+    uniform_slots.assign(capacity, {0, -1, false});
+
+    const size_t mask = capacity - 1;
+    for (const auto& uniform : active) {
+        size_t i = uniform.hash & mask;
+        while (uniform_slots[i].location >= 0 && uniform_slots[i].hash != uniform.hash)
+            i = (i + 1) & mask;
+        // GLSL names are unique, an occupied slot with the same hash is a collision
+        if (uniform_slots[i].location >= 0) {
+            std::cerr << "WARNING::SHADER::UNIFORM_HASH_COLLISION program " << program_id
+                      << ", the colliding uniforms are looked up by name" << std::endl;
+            uniform_slots[i].collides = true;
+            continue;
+        }
+        uniform_slots[i] = uniform;
+    }
+}
+
+const Shader::UniformSlot* Shader::find_uniform_slot(UniformHash hash) const
+{
+    if (uniform_slots.empty())
+        return nullptr;
+
+    const size_t mask = uniform_slots.size() - 1;
+    for (size_t i = hash & mask; uniform_slots[i].location >= 0; i = (i + 1) & mask) {
+        if (uniform_slots[i].hash == hash)
+            return &uniform_slots[i];
+    }
+    return nullptr;
+}
+
+UniformHandle Shader::get_uniform(UniformHash hash) const
+{
+    const UniformSlot* slot = find_uniform_slot(hash);
+    if (!slot || slot->collides)
+        return {};
+    return {slot->location};
+}
+
+UniformHandle Shader::get_uniform(std::string_view name) const
+{
+    const UniformSlot* slot = find_uniform_slot(hash_uniform_name(name));
+    if (!slot)
+        return {};
+    if (slot->collides)
+        return {glGetUniformLocation(program_id, std::string(name).c_str())};
+    return {slot->location};
+}
+
+UniformHandle Shader::get_uniform(std::string_view array, unsigned int index, std::string_view member) const
+{
+    const UniformSlot* slot = find_uniform_slot(hash_indexed_uniform_name(array, index, member));
+    if (!slot)
+        return {};
+    if (slot->collides) {
+        const std::string name = std::string(array) + '[' + std::to_string(index) + "]." + std::string(member);
+        return {glGetUniformLocation(program_id, name.c_str())};
+    }
+    return {slot->location};
 }
 
 void Shader::use() const
 {
-    GL_CALL(glUseProgram(program_id));
+    GLStateCache::get().use_program(program_id);
 }
 
 void Shader::set_bool(const std::string& name, bool value) const
 {
-    GL_CALL(glUniform1i(glGetUniformLocation(program_id, name.c_str()), value));
+    GL_CALL(glUniform1i(get_uniform(name).location, value));
 }
 
 void Shader::set_int(const std::string& name, int value) const
 {
-    GL_CALL(glUniform1i(glGetUniformLocation(program_id, name.c_str()), value));
+    GL_CALL(glUniform1i(get_uniform(name).location, value));
 }
 
 void Shader::set_float(const std::string& name, float value) const
 {
-    GL_CALL(glUniform1f(glGetUniformLocation(program_id, name.c_str()), value));
+    GL_CALL(glUniform1f(get_uniform(name).location, value));
 }
 
 Shader::~Shader()
 {
     GL_CALL(glDeleteProgram(program_id));
+    GLStateCache::get().on_program_deleted(program_id);
 }
 
 void Shader::set_vec2(const std::string& name, const glm::vec2& vec) const
 {
-    GL_CALL(glUniform2fv(glGetUniformLocation(program_id, name.c_str()), 1, glm::value_ptr(vec)));
+    GL_CALL(glUniform2fv(get_uniform(name).location, 1, glm::value_ptr(vec)));
 }
 
 void Shader::set_vec3(const std::string& name, const glm::vec3& vec) const
 {
-    GL_CALL(glUniform3fv(glGetUniformLocation(program_id, name.c_str()), 1, glm::value_ptr(vec)));
+    GL_CALL(glUniform3fv(get_uniform(name).location, 1, glm::value_ptr(vec)));
 }
 
 void Shader::set_vec4(const std::string& name, const glm::vec4& vec) const
 {
-    GL_CALL(glUniform4fv(glGetUniformLocation(program_id, name.c_str()), 1, glm::value_ptr(vec)));
+    GL_CALL(glUniform4fv(get_uniform(name).location, 1, glm::value_ptr(vec)));
 }
 
 void Shader::set_mat4(const std::string& name, const glm::mat4& mat) const
 {
-    GL_CALL(glUniformMatrix4fv(glGetUniformLocation(program_id, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat)));
+    GL_CALL(glUniformMatrix4fv(get_uniform(name).location, 1, GL_FALSE, glm::value_ptr(mat)));
 }
 
 unsigned int Shader::get_program() const
@@ -139,5 +267,53 @@ unsigned int Shader::get_program() const
 
 void Shader::set_mat3(const std::string& name, const glm::mat3 mat) const
 {
-    GL_CALL(glUniformMatrix3fv(glGetUniformLocation(program_id, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat)));
+    GL_CALL(glUniformMatrix3fv(get_uniform(name).location, 1, GL_FALSE, glm::value_ptr(mat)));
+}
+
+void Shader::set_bool(UniformHandle handle, bool value) const
+{
+    GL_CALL(glUniform1i(handle.location, value));
+}
+
+void Shader::set_int(UniformHandle handle, int value) const
+{
+    GL_CALL(glUniform1i(handle.location, value));
+}
+
+void Shader::set_float(UniformHandle handle, float value) const
+{
+    GL_CALL(glUniform1f(handle.location, value));
+}
+
+void Shader::set_vec2(UniformHandle handle, const glm::vec2& vec) const
+{
+    GL_CALL(glUniform2fv(handle.location, 1, glm::value_ptr(vec)));
+}
+
+void Shader::set_vec3(UniformHandle handle, const glm::vec3& vec) const
+{
+    GL_CALL(glUniform3fv(handle.location, 1, glm::value_ptr(vec)));
+}
+
+void Shader::set_vec4(UniformHandle handle, const glm::vec4& vec) const
+{
+    GL_CALL(glUniform4fv(handle.location, 1, glm::value_ptr(vec)));
+}
+
+void Shader::set_mat3(UniformHandle handle, const glm::mat3& mat) const
+{
+    GL_CALL(glUniformMatrix3fv(handle.location, 1, GL_FALSE, glm::value_ptr(mat)));
+}
+
+void Shader::set_mat4(UniformHandle handle, const glm::mat4& mat) const
+{
+    GL_CALL(glUniformMatrix4fv(handle.location, 1, GL_FALSE, glm::value_ptr(mat)));
+}
+
+void Shader::set_uniform_block_binding(const std::string& block_name, unsigned int binding) const
+{
+    const unsigned int index = glGetUniformBlockIndex(program_id, block_name.c_str());
+    if (index == GL_INVALID_INDEX)
+        return;
+    GL_CALL(glUniformBlockBinding(program_id, index, binding));
 }
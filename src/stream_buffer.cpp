@@ -0,0 +1,154 @@
+#include "stream_buffer.h"
+
+#include <iostream>
+
+#include "gl_extensions.h"
+#include "gl_state_cache.h"
+#include "utility.h"
+
+// region starts keep the largest uniform offset alignment drivers ask for
+static constexpr size_t REGION_ALIGNMENT = 256;
+static constexpr GLuint64 WAIT_TIMEOUT_NS = 1000000;
+
+StreamBuffer::StreamBuffer(size_t region_size, unsigned int region_count):
+	renderer_id(0),
+	region_size((region_size + REGION_ALIGNMENT - 1) / REGION_ALIGNMENT * REGION_ALIGNMENT),
+	region_count(region_count > 0 ? region_count : 1),
+	region(0),
+	head(0),
+	flushed(0),
+	stall_count(0),
+	mapped(nullptr),
+	fences(this->region_count, nullptr)
+{
+	const size_t size = this->region_size * this->region_count;
+	GLStateCache& state = GLStateCache::get();
+
+	GL_CALL(glGenBuffers(1, &renderer_id));
+	state.bind_buffer(GL_COPY_WRITE_BUFFER, renderer_id);
+
+	const GLExtensions& ext = gl_extensions();
+	if (ext.buffer_storage) {
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		GL_CALL(ext.BufferStorage(GL_COPY_WRITE_BUFFER, size, nullptr, flags));
+		mapped = static_cast<std::byte*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, flags));
+		if (mapped)
+			return;
+
+		// immutable storage cannot be respecified, start over with a mutable buffer
+		std::cerr << "StreamBuffer failed to map " << size << " bytes persistently, falling back to glBufferSubData" << std::endl;
+		GL_CALL(glDeleteBuffers(1, &renderer_id));
+		state.on_buffer_deleted(renderer_id);
+		GL_CALL(glGenBuffers(1, &renderer_id));
+		state.bind_buffer(GL_COPY_WRITE_BUFFER, renderer_id);
+	}
+
+	GL_CALL(glBufferData(GL_COPY_WRITE_BUFFER, size, nullptr, GL_STREAM_DRAW));
+	staging.resize(size);
+}
+
+StreamBuffer::~StreamBuffer()
+{
+	for (GLsync fence : fences) {
+		if (fence)
+			GL_CALL(glDeleteSync(fence));
+	}
+	if (mapped) {
+		GLStateCache::get().bind_buffer(GL_COPY_WRITE_BUFFER, renderer_id);
+		GL_CALL(glUnmapBuffer(GL_COPY_WRITE_BUFFER));
+	}
+	GL_CALL(glDeleteBuffers(1, &renderer_id));
+	GLStateCache::get().on_buffer_deleted(renderer_id);
+}
+
+void StreamBuffer::begin_frame()
+{
+	GLsync fence = fences[region];
+	if (fence) {
+		GLenum result = glClientWaitSync(fence, 0, 0);
+		if (result == GL_TIMEOUT_EXPIRED) {
+			++stall_count;
+			do
+				result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, WAIT_TIMEOUT_NS);
+			while (result == GL_TIMEOUT_EXPIRED);
+		}
+		if (result == GL_WAIT_FAILED)
+			std::cerr << "StreamBuffer failed to wait for region " << region << std::endl;
+		GL_CALL(glDeleteSync(fence));
+		fences[region] = nullptr;
+	}
+	head = 0;
+	flushed = 0;
+}
+
+void StreamBuffer::end_frame()
+{
+	flush();
+	fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	region = (region + 1) % region_count;
+	head = 0;
+	flushed = 0;
+}
+
+StreamBuffer::Allocation StreamBuffer::allocate(size_t size, size_t alignment)
+{
+	const size_t start = alignment > 1 ? (head + alignment - 1) / alignment * alignment : head;
+	if (start + size > region_size) {
+		std::cerr << "StreamBuffer region of " << region_size << " bytes cannot fit " << size
+			<< " more bytes at " << start << std::endl;
+		return {nullptr, 0};
+	}
+
+	head = start + size;
+	const size_t offset = region * region_size + start;
+	std::byte *base = mapped ? mapped : staging.data();
+	return {base + offset, offset};
+}
+
+void StreamBuffer::flush()
+{
+	if (mapped || head == flushed)
+		return;
+
+	const size_t offset = region * region_size + flushed;
+	GLStateCache::get().bind_buffer(GL_COPY_WRITE_BUFFER, renderer_id);
+	GL_CALL(glBufferSubData(GL_COPY_WRITE_BUFFER, offset, head - flushed, staging.data() + offset));
+	flushed = head;
+}
+
+void StreamBuffer::bind(GLenum target) const
+{
+	GLStateCache::get().bind_buffer(target, renderer_id);
+}
+
+void StreamBuffer::bind_range(GLenum target, unsigned int index, size_t offset, size_t size) const
+{
+	// keeps the cached generic binding in sync with what glBindBufferRange sets
+	bind(target);
+	GL_CALL(glBindBufferRange(target, index, renderer_id, offset, size));
+}
+
+unsigned int StreamBuffer::get_renderer_id() const
+{
+	return renderer_id;
+}
+
+bool StreamBuffer::is_persistent() const
+{
+	return mapped != nullptr;
+}
+
+unsigned int StreamBuffer::get_stall_count() const
+{
+	return stall_count;
+}
+
+size_t StreamBuffer::get_uniform_alignment()
+{
+	static const size_t alignment = [] {
+		GLint value = 0;
+		GL_CALL(glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &value));
+		return value > 0 ? static_cast<size_t>(value) : size_t(256);
+	}();
+	return alignment;
+}
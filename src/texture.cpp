@@ -2,6 +2,9 @@
 
 #include <glad/glad.h>
 
+#include "async_texture_loader.h"
+#include "gl_state_cache.h"
+#include "texture_upload.h"
 #include "utility.h"
 
 #include <string>
@@ -9,61 +12,64 @@
 
 #include <stb_image.h>
 
-Texture::Texture(const std::string &image_src_path) : renderer_id(0)
+Texture::Texture(const std::string &image_src_path) : renderer_id(0), loader(nullptr)
 {
-	GL_CALL(glGenTextures(1, &renderer_id));
-    load_image(image_src_path);
+    renderer_id = load_image(image_src_path);
 }
 
-void Texture::load_image(const std::string& image_src_path) const
+Texture::Texture(const std::string &image_src_path, AsyncTextureLoader &loader) : renderer_id(0), loader(&loader)
 {
+	renderer_id = loader.load(image_src_path);
+}
+
+unsigned int Texture::load_image(const std::string& image_src_path)
+{
+    // KTX2/DDS written by the texture encoder, already mipmapped and a fraction of the size
+    if (const unsigned int texture = load_compressed_texture(image_src_path, false))
+        return texture;
+
     int width = 0;
     int height = 0;
     int text_channels = 0;
-    unsigned char *data = stbi_load(
-        image_src_path.c_str(),
-        &width,
-        &height,
-        &text_channels,
-        0
+    unsigned char *data = decode_image_file(
+        image_src_path,
+        width,
+        height,
+        text_channels
     );
 
+    unsigned int texture = 0;
     if (data) {
-        GLenum format = GL_RGB;
-        if (text_channels == 1)
-            format = GL_RED;
-        else if (text_channels == 3)
-            format = GL_RGB;
-        else if (text_channels == 4)
-            format = GL_RGBA;
-
-        GL_CALL(glBindTexture(GL_TEXTURE_2D, renderer_id));
-        GL_CALL(glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data));
-        GL_CALL(glGenerateMipmap(GL_TEXTURE_2D));
-        GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT));
-        GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT));
-        GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR));
-        GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+        texture = create_texture_2d(width, height, text_channels, false, data);
     }
     else {
         std::cerr << "Failed to load texture from file "
             << image_src_path << std::endl;
     }
     stbi_image_free(data);
+    return texture;
 }
 
 void Texture::bind() const
 {
-	GL_CALL(glBindTexture(GL_TEXTURE_2D, renderer_id));
+	GLStateCache::get().bind_texture(GL_TEXTURE_2D, renderer_id);
+}
+
+void Texture::bind(unsigned int unit) const
+{
+	GLStateCache::get().bind_texture(unit, GL_TEXTURE_2D, renderer_id);
 }
 
 void Texture::unbind() const
 {
-	GL_CALL(glBindTexture(GL_TEXTURE_2D, 0));
+	GLStateCache::get().bind_texture(GL_TEXTURE_2D, 0);
 }
 
 Texture::~Texture()
 {
     unbind();
+    if (loader)
+        loader->cancel(renderer_id);
     GL_CALL(glDeleteTextures(1, &renderer_id));
+    GLStateCache::get().on_texture_deleted(renderer_id);
 }
\ No newline at end of file
@@ -0,0 +1,367 @@
+#include "texture_container.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <span>
+
+#include <stb_image.h>
+
+// DDS layout from the DirectX documentation, every field is little endian
+
+static constexpr char DDS_MAGIC[4] = {'D', 'D', 'S', ' '};
+
+static constexpr std::uint32_t DDSD_CAPS = 0x1;
+static constexpr std::uint32_t DDSD_HEIGHT = 0x2;
+static constexpr std::uint32_t DDSD_WIDTH = 0x4;
+static constexpr std::uint32_t DDSD_PIXELFORMAT = 0x1000;
+static constexpr std::uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+static constexpr std::uint32_t DDSD_LINEARSIZE = 0x80000;
+static constexpr std::uint32_t DDPF_FOURCC = 0x4;
+static constexpr std::uint32_t DDSCAPS_COMPLEX = 0x8;
+static constexpr std::uint32_t DDSCAPS_TEXTURE = 0x1000;
+static constexpr std::uint32_t DDSCAPS_MIPMAP = 0x400000;
+static constexpr std::uint32_t DDSCAPS2_CUBEMAP = 0x200;
+static constexpr std::uint32_t DDSCAPS2_VOLUME = 0x200000;
+static constexpr std::uint32_t DDS_DIMENSION_TEXTURE2D = 3;
+
+static constexpr std::uint32_t DXGI_FORMAT_BC1_UNORM = 71;
+static constexpr std::uint32_t DXGI_FORMAT_BC1_UNORM_SRGB = 72;
+static constexpr std::uint32_t DXGI_FORMAT_BC3_UNORM = 77;
+static constexpr std::uint32_t DXGI_FORMAT_BC3_UNORM_SRGB = 78;
+static constexpr std::uint32_t DXGI_FORMAT_BC5_UNORM = 83;
+static constexpr std::uint32_t DXGI_FORMAT_BC7_UNORM = 98;
+static constexpr std::uint32_t DXGI_FORMAT_BC7_UNORM_SRGB = 99;
+
+struct DdsPixelFormat {
+	std::uint32_t size;
+	std::uint32_t flags;
+	std::uint32_t four_cc;
+	std::uint32_t rgb_bit_count;
+	std::uint32_t bit_masks[4];
+};
+
+struct DdsHeader {
+	std::uint32_t size;
+	std::uint32_t flags;
+	std::uint32_t height;
+	std::uint32_t width;
+	std::uint32_t pitch_or_linear_size;
+	std::uint32_t depth;
+	std::uint32_t mip_map_count;
+	std::uint32_t reserved1[11];
+	DdsPixelFormat pixel_format;
+	std::uint32_t caps;
+	std::uint32_t caps2;
+	std::uint32_t caps3;
+	std::uint32_t caps4;
+	std::uint32_t reserved2;
+};
+
+struct DdsHeaderDx10 {
+	std::uint32_t dxgi_format;
+	std::uint32_t resource_dimension;
+	std::uint32_t misc_flag;
+	std::uint32_t array_size;
+	std::uint32_t misc_flags2;
+};
+
+static_assert(sizeof(DdsPixelFormat) == 32 && sizeof(DdsHeader) == 124 && sizeof(DdsHeaderDx10) == 20);
+
+// KTX2 layout from the Khronos specification, vkFormat values from vulkan_core.h
+
+static constexpr unsigned char KTX2_IDENTIFIER[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+static constexpr std::uint32_t VK_FORMAT_BC1_RGB_UNORM_BLOCK = 131;
+static constexpr std::uint32_t VK_FORMAT_BC1_RGB_SRGB_BLOCK = 132;
+static constexpr std::uint32_t VK_FORMAT_BC1_RGBA_UNORM_BLOCK = 133;
+static constexpr std::uint32_t VK_FORMAT_BC1_RGBA_SRGB_BLOCK = 134;
+static constexpr std::uint32_t VK_FORMAT_BC3_UNORM_BLOCK = 137;
+static constexpr std::uint32_t VK_FORMAT_BC3_SRGB_BLOCK = 138;
+static constexpr std::uint32_t VK_FORMAT_BC5_UNORM_BLOCK = 141;
+static constexpr std::uint32_t VK_FORMAT_BC7_UNORM_BLOCK = 145;
+static constexpr std::uint32_t VK_FORMAT_BC7_SRGB_BLOCK = 146;
+
+struct Ktx2Header {
+	unsigned char identifier[12];
+	std::uint32_t vk_format;
+	std::uint32_t type_size;
+	std::uint32_t pixel_width;
+	std::uint32_t pixel_height;
+	std::uint32_t pixel_depth;
+	std::uint32_t layer_count;
+	std::uint32_t face_count;
+	std::uint32_t level_count;
+	std::uint32_t supercompression_scheme;
+	std::uint32_t dfd_byte_offset;
+	std::uint32_t dfd_byte_length;
+	std::uint32_t kvd_byte_offset;
+	std::uint32_t kvd_byte_length;
+	std::uint64_t sgd_byte_offset;
+	std::uint64_t sgd_byte_length;
+};
+
+struct Ktx2Level {
+	std::uint64_t byte_offset;
+	std::uint64_t byte_length;
+	std::uint64_t uncompressed_byte_length;
+};
+
+static_assert(sizeof(Ktx2Header) == 80 && sizeof(Ktx2Level) == 24);
+
+static constexpr std::uint32_t make_four_cc(char a, char b, char c, char d)
+{
+	return std::uint32_t(std::uint8_t(a)) | std::uint32_t(std::uint8_t(b)) << 8
+		| std::uint32_t(std::uint8_t(c)) << 16 | std::uint32_t(std::uint8_t(d)) << 24;
+}
+
+size_t get_block_size(BlockFormat format)
+{
+	return format == BlockFormat::BC1 ? 8 : 16;
+}
+
+size_t get_compressed_level_size(BlockFormat format, int width, int height)
+{
+	const auto blocks_x = static_cast<size_t>(std::max((width + 3) / 4, 1));
+	const auto blocks_y = static_cast<size_t>(std::max((height + 3) / 4, 1));
+	return blocks_x * blocks_y * get_block_size(format);
+}
+
+const unsigned char* CompressedImage::get_level_data(size_t level) const
+{
+	return (data.empty() ? file.get_data() : data.data()) + levels[level].offset;
+}
+
+// lays out level_count levels of a width x height image back to back from
+// offset, false when the file is too short for them
+static bool set_levels(CompressedImage &image, int width, int height, unsigned int level_count, size_t offset, size_t available)
+{
+	image.levels.clear();
+	size_t size = 0;
+	for (unsigned int i = 0; i < level_count; ++i) {
+		image.levels.push_back({width, height, offset + size});
+		size += get_compressed_level_size(image.format, width, height);
+		if (width == 1 && height == 1)
+			break;
+		width = std::max(width / 2, 1);
+		height = std::max(height / 2, 1);
+	}
+	return size <= available;
+}
+
+static bool read_dds(const std::string &path, std::span<const unsigned char> bytes, CompressedImage &image)
+{
+	DdsHeader header;
+	if (bytes.size() < sizeof(DDS_MAGIC) + sizeof(header)) {
+		std::cerr << "DDS file " << path << " is truncated" << std::endl;
+		return false;
+	}
+	std::memcpy(&header, bytes.data() + sizeof(DDS_MAGIC), sizeof(header));
+	size_t data_offset = sizeof(DDS_MAGIC) + sizeof(header);
+
+	if (header.size != sizeof(DdsHeader) || header.pixel_format.size != sizeof(DdsPixelFormat)
+		|| !(header.pixel_format.flags & DDPF_FOURCC)) {
+		std::cerr << "DDS file " << path << " is not block compressed" << std::endl;
+		return false;
+	}
+	if (header.caps2 & (DDSCAPS2_CUBEMAP | DDSCAPS2_VOLUME)) {
+		std::cerr << "DDS file " << path << " is not a 2D texture" << std::endl;
+		return false;
+	}
+
+	image.srgb = false;
+	const std::uint32_t four_cc = header.pixel_format.four_cc;
+	if (four_cc == make_four_cc('D', 'X', 'T', '1'))
+		image.format = BlockFormat::BC1;
+	else if (four_cc == make_four_cc('D', 'X', 'T', '5'))
+		image.format = BlockFormat::BC3;
+	else if (four_cc == make_four_cc('A', 'T', 'I', '2') || four_cc == make_four_cc('B', 'C', '5', 'U'))
+		image.format = BlockFormat::BC5;
+	else if (four_cc == make_four_cc('D', 'X', '1', '0')) {
+		DdsHeaderDx10 dx10;
+		if (bytes.size() < data_offset + sizeof(dx10)) {
+			std::cerr << "DDS file " << path << " is truncated" << std::endl;
+			return false;
+		}
+		std::memcpy(&dx10, bytes.data() + data_offset, sizeof(dx10));
+		data_offset += sizeof(dx10);
+		if (dx10.resource_dimension != DDS_DIMENSION_TEXTURE2D || dx10.array_size > 1) {
+			std::cerr << "DDS file " << path << " is not a 2D texture" << std::endl;
+			return false;
+		}
+		switch (dx10.dxgi_format) {
+		case DXGI_FORMAT_BC1_UNORM_SRGB: image.srgb = true; [[fallthrough]];
+		case DXGI_FORMAT_BC1_UNORM: image.format = BlockFormat::BC1; break;
+		case DXGI_FORMAT_BC3_UNORM_SRGB: image.srgb = true; [[fallthrough]];
+		case DXGI_FORMAT_BC3_UNORM: image.format = BlockFormat::BC3; break;
+		case DXGI_FORMAT_BC5_UNORM: image.format = BlockFormat::BC5; break;
+		case DXGI_FORMAT_BC7_UNORM_SRGB: image.srgb = true; [[fallthrough]];
+		case DXGI_FORMAT_BC7_UNORM: image.format = BlockFormat::BC7; break;
+		default:
+			std::cerr << "DDS file " << path << " has unsupported DXGI format " << dx10.dxgi_format << std::endl;
+			return false;
+		}
+	}
+	else {
+		std::cerr << "DDS file " << path << " has unsupported format "
+			<< std::string(reinterpret_cast<const char*>(&four_cc), 4) << std::endl;
+		return false;
+	}
+
+	const unsigned int level_count = (header.flags & DDSD_MIPMAPCOUNT) && header.mip_map_count > 0 ? header.mip_map_count : 1;
+	if (header.width == 0 || header.height == 0
+		|| !set_levels(image, static_cast<int>(header.width), static_cast<int>(header.height), level_count, data_offset, bytes.size() - data_offset)) {
+		std::cerr << "DDS file " << path << " is truncated" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+static bool read_ktx2(const std::string &path, std::span<const unsigned char> bytes, CompressedImage &image)
+{
+	Ktx2Header header;
+	if (bytes.size() < sizeof(header)) {
+		std::cerr << "KTX2 file " << path << " is truncated" << std::endl;
+		return false;
+	}
+	std::memcpy(&header, bytes.data(), sizeof(header));
+
+	if (header.supercompression_scheme != 0) {
+		std::cerr << "KTX2 file " << path << " is supercompressed, only plain block compressed data is supported" << std::endl;
+		return false;
+	}
+	if (header.pixel_width == 0 || header.pixel_height == 0 || header.pixel_depth > 1
+		|| header.layer_count > 1 || header.face_count != 1) {
+		std::cerr << "KTX2 file " << path << " is not a 2D texture" << std::endl;
+		return false;
+	}
+
+	image.srgb = false;
+	switch (header.vk_format) {
+	case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+	case VK_FORMAT_BC1_RGBA_SRGB_BLOCK: image.srgb = true; [[fallthrough]];
+	case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+	case VK_FORMAT_BC1_RGBA_UNORM_BLOCK: image.format = BlockFormat::BC1; break;
+	case VK_FORMAT_BC3_SRGB_BLOCK: image.srgb = true; [[fallthrough]];
+	case VK_FORMAT_BC3_UNORM_BLOCK: image.format = BlockFormat::BC3; break;
+	case VK_FORMAT_BC5_UNORM_BLOCK: image.format = BlockFormat::BC5; break;
+	case VK_FORMAT_BC7_SRGB_BLOCK: image.srgb = true; [[fallthrough]];
+	case VK_FORMAT_BC7_UNORM_BLOCK: image.format = BlockFormat::BC7; break;
+	default:
+		std::cerr << "KTX2 file " << path << " has unsupported vkFormat " << header.vk_format << std::endl;
+		return false;
+	}
+
+	// a level count of 0 asks the loader to generate mips, which block compressed data cannot get
+	const unsigned int level_count = std::max(header.level_count, 1u);
+	if (bytes.size() < sizeof(header) + level_count * sizeof(Ktx2Level)) {
+		std::cerr << "KTX2 file " << path << " is truncated" << std::endl;
+		return false;
+	}
+	set_levels(image, static_cast<int>(header.pixel_width), static_cast<int>(header.pixel_height), level_count, 0, SIZE_MAX);
+
+	// levels are listed largest first but may be stored in any order, point at each where it is
+	for (size_t i = 0; i < image.levels.size(); ++i) {
+		Ktx2Level level;
+		std::memcpy(&level, bytes.data() + sizeof(header) + i * sizeof(Ktx2Level), sizeof(level));
+		MipLevel &mip = image.levels[i];
+		const size_t size = get_compressed_level_size(image.format, mip.width, mip.height);
+		if (level.byte_length != size || level.byte_offset > bytes.size() || size > bytes.size() - level.byte_offset) {
+			std::cerr << "KTX2 file " << path << " level " << i << " is truncated or has the wrong size" << std::endl;
+			return false;
+		}
+		mip.offset = static_cast<size_t>(level.byte_offset);
+	}
+	return true;
+}
+
+bool read_compressed_image(const std::string &path, CompressedImage &image)
+{
+	// the levels are uploaded right after, start reading them in
+	image.data.clear();
+	if (!VirtualFileSystem::get().open(path, image.file, MappedFile::Access::WillNeed)) {
+		std::cerr << "Failed to read compressed texture " << path << std::endl;
+		return false;
+	}
+
+	const std::span<const unsigned char> bytes(image.file.get_data(), image.file.get_size());
+	bool read = false;
+	if (bytes.size() >= sizeof(DDS_MAGIC) && std::memcmp(bytes.data(), DDS_MAGIC, sizeof(DDS_MAGIC)) == 0)
+		read = read_dds(path, bytes, image);
+	else if (bytes.size() >= sizeof(KTX2_IDENTIFIER) && std::memcmp(bytes.data(), KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) == 0)
+		read = read_ktx2(path, bytes, image);
+	else
+		std::cerr << "Compressed texture " << path << " is neither DDS nor KTX2" << std::endl;
+	if (!read)
+		image.file.close();
+	return read;
+}
+
+bool write_dds(const std::string &path, const CompressedImage &image)
+{
+	const MipLevel &base = image.levels.front();
+
+	DdsHeader header{};
+	header.size = sizeof(DdsHeader);
+	header.flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE;
+	header.height = static_cast<std::uint32_t>(base.height);
+	header.width = static_cast<std::uint32_t>(base.width);
+	header.pitch_or_linear_size = static_cast<std::uint32_t>(get_compressed_level_size(image.format, base.width, base.height));
+	header.mip_map_count = static_cast<std::uint32_t>(image.levels.size());
+	header.pixel_format.size = sizeof(DdsPixelFormat);
+	header.pixel_format.flags = DDPF_FOURCC;
+	header.pixel_format.four_cc = make_four_cc('D', 'X', '1', '0');
+	header.caps = DDSCAPS_TEXTURE | (image.levels.size() > 1 ? DDSCAPS_COMPLEX | DDSCAPS_MIPMAP : 0);
+
+	DdsHeaderDx10 dx10{};
+	switch (image.format) {
+	case BlockFormat::BC1: dx10.dxgi_format = image.srgb ? DXGI_FORMAT_BC1_UNORM_SRGB : DXGI_FORMAT_BC1_UNORM; break;
+	case BlockFormat::BC3: dx10.dxgi_format = image.srgb ? DXGI_FORMAT_BC3_UNORM_SRGB : DXGI_FORMAT_BC3_UNORM; break;
+	case BlockFormat::BC5: dx10.dxgi_format = DXGI_FORMAT_BC5_UNORM; break;
+	case BlockFormat::BC7: dx10.dxgi_format = image.srgb ? DXGI_FORMAT_BC7_UNORM_SRGB : DXGI_FORMAT_BC7_UNORM; break;
+	}
+	dx10.resource_dimension = DDS_DIMENSION_TEXTURE2D;
+	dx10.array_size = 1;
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write(DDS_MAGIC, sizeof(DDS_MAGIC));
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(&dx10), sizeof(dx10));
+	for (size_t i = 0; i < image.levels.size(); ++i) {
+		const MipLevel &level = image.levels[i];
+		file.write(reinterpret_cast<const char*>(image.get_level_data(i)),
+			static_cast<std::streamsize>(get_compressed_level_size(image.format, level.width, level.height)));
+	}
+	if (!file) {
+		std::cerr << "Failed to write " << path << std::endl;
+		return false;
+	}
+	return true;
+}
+
+unsigned char* decode_image_file(const std::string &path, int &width, int &height, int &channels, int desired_channels)
+{
+	AssetFile file;
+	if (!VirtualFileSystem::get().open(path, file) || file.get_size() > static_cast<size_t>(INT_MAX))
+		return nullptr;
+	return stbi_load_from_memory(file.get_data(), static_cast<int>(file.get_size()), &width, &height, &channels, desired_channels);
+}
+
+std::string find_compressed_texture(const std::string &image_path)
+{
+	std::filesystem::path path(image_path);
+	const std::string extension = path.extension().string();
+	if (extension == ".dds" || extension == ".ktx2")
+		return image_path;
+
+	for (const char *compressed_extension : {".ktx2", ".dds"}) {
+		path.replace_extension(compressed_extension);
+		if (VirtualFileSystem::get().exists(path.string()))
+			return path.string();
+	}
+	return {};
+}
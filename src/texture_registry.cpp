@@ -0,0 +1,100 @@
+#include "texture_registry.h"
+
+#include <glad/glad.h>
+
+#include <filesystem>
+#include <iostream>
+#include <system_error>
+
+#include <stb_image.h>
+
+#include "async_texture_loader.h"
+#include "gl_state_cache.h"
+#include "texture_upload.h"
+#include "utility.h"
+
+static unsigned int load_texture(const std::string &image_path, TextureRegistry::Options options)
+{
+	unsigned int texture_id = load_compressed_texture(image_path, options.gamma);
+	if (texture_id != 0)
+		return texture_id;
+
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+	unsigned char *data = decode_image_file(image_path, width, height, channels, options.channels);
+	if (data) {
+		texture_id = create_texture_2d(width, height, options.channels ? options.channels : channels, options.gamma, data);
+	}
+	else {
+		std::cerr << "Failed to load texture from file "
+			<< image_path << std::endl;
+		// still a distinct object, the registry tells entries apart by texture id
+		GL_CALL(glGenTextures(1, &texture_id));
+	}
+	stbi_image_free(data);
+	return texture_id;
+}
+
+TextureRegistry& TextureRegistry::get()
+{
+	static TextureRegistry registry;
+	return registry;
+}
+
+std::string TextureRegistry::make_key(const std::string &image_path, Options options)
+{
+	// different spellings of the same file ("a/../b.png", "./b.png") share an entry
+	std::error_code error;
+	std::filesystem::path path = std::filesystem::weakly_canonical(image_path, error);
+	if (error)
+		path = std::filesystem::path(image_path).lexically_normal();
+
+	std::string key = path.generic_string();
+	key += options.gamma ? "|srgb" : "|linear";
+	key += "|" + std::to_string(options.channels);
+	return key;
+}
+
+unsigned int TextureRegistry::acquire(const std::string &image_path, Options options, AsyncTextureLoader *loader)
+{
+	std::string key = make_key(image_path, options);
+	const auto it = entries.find(key);
+	if (it != entries.end()) {
+		++it->second.references;
+		return it->second.texture_id;
+	}
+
+	const unsigned int texture_id = loader
+		? loader->load(image_path, options.gamma, options.channels)
+		: load_texture(image_path, options);
+	keys.emplace(texture_id, key);
+	entries.emplace(std::move(key), Entry{texture_id, 1, loader});
+	return texture_id;
+}
+
+void TextureRegistry::release(unsigned int texture_id)
+{
+	const auto key = keys.find(texture_id);
+	if (key == keys.end()) {
+		std::cerr << "Released texture " << texture_id
+			<< " that is not in the texture registry" << std::endl;
+		return;
+	}
+
+	const auto it = entries.find(key->second);
+	if (--it->second.references > 0)
+		return;
+
+	if (it->second.loader)
+		it->second.loader->cancel(texture_id);
+	GL_CALL(glDeleteTextures(1, &texture_id));
+	GLStateCache::get().on_texture_deleted(texture_id);
+	entries.erase(it);
+	keys.erase(key);
+}
+
+size_t TextureRegistry::size() const
+{
+	return entries.size();
+}
@@ -0,0 +1,143 @@
+#include "texture_upload.h"
+
+#include <iostream>
+
+#include "gl_extensions.h"
+#include "gl_state_cache.h"
+#include "utility.h"
+
+TextureFormat get_texture_format(int channels, bool srgb)
+{
+	switch (channels) {
+	case 1: return {GL_RED, GL_R8};
+	case 2: return {GL_RG, GL_RG8};
+	case 4: return {GL_RGBA, static_cast<GLenum>(srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8)};
+	default: return {GL_RGB, static_cast<GLenum>(srgb ? GL_SRGB8 : GL_RGB8)};
+	}
+}
+
+GLenum get_compressed_internal_format(BlockFormat format, bool srgb)
+{
+	switch (format) {
+	case BlockFormat::BC1: return srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+	case BlockFormat::BC3: return srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	case BlockFormat::BC5: return GL_COMPRESSED_RG_RGTC2;
+	default: return srgb ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : GL_COMPRESSED_RGBA_BPTC_UNORM;
+	}
+}
+
+bool is_block_format_supported(BlockFormat format)
+{
+	if (format == BlockFormat::BC1 || format == BlockFormat::BC3)
+		return gl_extensions().texture_compression_s3tc;
+	return true;
+}
+
+unsigned int create_texture_2d(const MipChain &chain)
+{
+	const TextureFormat format = get_texture_format(chain.channels, chain.srgb);
+	const auto levels = static_cast<GLsizei>(chain.levels.size());
+	const int width = chain.levels[0].width;
+	const int height = chain.levels[0].height;
+	unsigned int texture = 0;
+
+	// rows of 1 and 3 channel images are not 4 byte aligned in general
+	GL_CALL(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+	const GLExtensions& ext = gl_extensions();
+	if (ext.direct_state_access) {
+		GL_CALL(ext.CreateTextures(GL_TEXTURE_2D, 1, &texture));
+		GL_CALL(ext.TextureStorage2D(texture, levels, format.internal_format, width, height));
+		for (GLint i = 0; i < levels; ++i) {
+			const MipLevel &level = chain.levels[i];
+			GL_CALL(ext.TextureSubImage2D(texture, i, 0, 0, level.width, level.height, format.format, GL_UNSIGNED_BYTE,
+				chain.data.data() + level.offset));
+		}
+	}
+	else {
+		GL_CALL(glGenTextures(1, &texture));
+		GLStateCache::get().bind_texture(GL_TEXTURE_2D, texture);
+		GL_CALL(glTexStorage2D(GL_TEXTURE_2D, levels, format.internal_format, width, height));
+		for (GLint i = 0; i < levels; ++i) {
+			const MipLevel &level = chain.levels[i];
+			GL_CALL(glTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, level.width, level.height, format.format, GL_UNSIGNED_BYTE,
+				chain.data.data() + level.offset));
+		}
+	}
+	GL_CALL(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+
+	set_texture_sampling(texture, GL_LINEAR_MIPMAP_LINEAR);
+	return texture;
+}
+
+unsigned int create_texture_2d(int width, int height, int channels, bool srgb, const unsigned char *pixels)
+{
+	return create_texture_2d(generate_mip_chain(pixels, width, height, channels, srgb));
+}
+
+unsigned int create_texture_2d(const CompressedImage &image, bool srgb)
+{
+	const GLenum internal_format = get_compressed_internal_format(image.format, srgb);
+	const auto levels = static_cast<GLsizei>(image.levels.size());
+	const int width = image.levels[0].width;
+	const int height = image.levels[0].height;
+	unsigned int texture = 0;
+
+	const GLExtensions& ext = gl_extensions();
+	if (ext.direct_state_access) {
+		GL_CALL(ext.CreateTextures(GL_TEXTURE_2D, 1, &texture));
+		GL_CALL(ext.TextureStorage2D(texture, levels, internal_format, width, height));
+		for (GLint i = 0; i < levels; ++i) {
+			const MipLevel &level = image.levels[i];
+			const auto size = static_cast<GLsizei>(get_compressed_level_size(image.format, level.width, level.height));
+			GL_CALL(ext.CompressedTextureSubImage2D(texture, i, 0, 0, level.width, level.height, internal_format, size,
+				image.get_level_data(i)));
+		}
+	}
+	else {
+		GL_CALL(glGenTextures(1, &texture));
+		GLStateCache::get().bind_texture(GL_TEXTURE_2D, texture);
+		GL_CALL(glTexStorage2D(GL_TEXTURE_2D, levels, internal_format, width, height));
+		for (GLint i = 0; i < levels; ++i) {
+			const MipLevel &level = image.levels[i];
+			const auto size = static_cast<GLsizei>(get_compressed_level_size(image.format, level.width, level.height));
+			GL_CALL(glCompressedTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, level.width, level.height, internal_format, size,
+				image.get_level_data(i)));
+		}
+	}
+
+	set_texture_sampling(texture, GL_LINEAR_MIPMAP_LINEAR);
+	return texture;
+}
+
+unsigned int load_compressed_texture(const std::string &image_path, bool srgb)
+{
+	const std::string path = find_compressed_texture(image_path);
+	if (path.empty())
+		return 0;
+
+	CompressedImage image;
+	if (!read_compressed_image(path, image))
+		return 0;
+	if (!is_block_format_supported(image.format)) {
+		std::cerr << "Compressed texture " << path << " needs S3TC, which the driver does not support" << std::endl;
+		return 0;
+	}
+	return create_texture_2d(image, srgb);
+}
+
+void set_texture_sampling(unsigned int texture, GLenum min_filter)
+{
+	const GLExtensions& ext = gl_extensions();
+	if (ext.direct_state_access) {
+		GL_CALL(ext.TextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_REPEAT));
+		GL_CALL(ext.TextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_REPEAT));
+		GL_CALL(ext.TextureParameteri(texture, GL_TEXTURE_MIN_FILTER, min_filter));
+		GL_CALL(ext.TextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+		return;
+	}
+	GLStateCache::get().bind_texture(GL_TEXTURE_2D, texture);
+	GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT));
+	GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT));
+	GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, min_filter));
+	GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+}
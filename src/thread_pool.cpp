@@ -0,0 +1,73 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+
+ThreadPool::ThreadPool(unsigned int thread_count): stopping(false)
+{
+	thread_count = std::max(thread_count, 1u);
+	workers.reserve(thread_count);
+	for (unsigned int i = 0; i < thread_count; ++i)
+		workers.emplace_back(&ThreadPool::worker_loop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard lock(mutex);
+		stopping = true;
+	}
+	task_available.notify_all();
+	for (auto &worker : workers)
+		worker.join();
+}
+
+void ThreadPool::worker_loop()
+{
+	for (;;) {
+		std::function<void()> task;
+		{
+			std::unique_lock lock(mutex);
+			task_available.wait(lock, [this] { return stopping || !tasks.empty(); });
+			if (stopping && tasks.empty())
+				return;
+			task = std::move(tasks.front());
+			tasks.pop_front();
+		}
+		task();
+	}
+}
+
+void ThreadPool::parallel_for(size_t count, const std::function<void(size_t)> &body)
+{
+	if (count == 0)
+		return;
+
+	std::atomic<size_t> next(0);
+	const auto run = [&] {
+		for (size_t i = next++; i < count; i = next++)
+			body(i);
+	};
+
+	const size_t helpers = std::min<size_t>(workers.size(), count - 1);
+	std::vector<std::future<void>> pending;
+	pending.reserve(helpers);
+	for (size_t i = 0; i < helpers; ++i)
+		pending.push_back(submit(run));
+
+	// the calling thread works too, so this finishes even when the workers are busy
+	run();
+	for (auto &f : pending)
+		f.wait();
+}
+
+unsigned int ThreadPool::get_thread_count() const
+{
+	return static_cast<unsigned int>(workers.size());
+}
+
+ThreadPool& ThreadPool::shared()
+{
+	static ThreadPool pool;
+	return pool;
+}
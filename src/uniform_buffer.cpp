@@ -0,0 +1,55 @@
+#include <glad/glad.h>
+
+#include "uniform_buffer.h"
+#include "gl_extensions.h"
+#include "gl_state_cache.h"
+#include "utility.h"
+
+UniformBuffer::UniformBuffer(size_t size, unsigned int binding): renderer_id(0), binding(binding)
+{
+	const GLExtensions& ext = gl_extensions();
+	if (ext.direct_state_access) {
+		// set_data then updates it without touching the GL_UNIFORM_BUFFER binding
+		GL_CALL(ext.CreateBuffers(1, &renderer_id));
+		GL_CALL(ext.NamedBufferStorage(renderer_id, size, nullptr, GL_DYNAMIC_STORAGE_BIT));
+		GLStateCache::get().bind_buffer(GL_UNIFORM_BUFFER, renderer_id);
+	}
+	else {
+		GL_CALL(glGenBuffers(1, &renderer_id));
+		GLStateCache::get().bind_buffer(GL_UNIFORM_BUFFER, renderer_id);
+		GL_CALL(glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW));
+	}
+	GL_CALL(glBindBufferBase(GL_UNIFORM_BUFFER, binding, renderer_id));
+}
+
+UniformBuffer::~UniformBuffer()
+{
+	GL_CALL(glDeleteBuffers(1, &renderer_id));
+	GLStateCache::get().on_buffer_deleted(renderer_id);
+}
+
+void UniformBuffer::bind() const
+{
+	GLStateCache::get().bind_buffer(GL_UNIFORM_BUFFER, renderer_id);
+}
+
+void UniformBuffer::unbind() const
+{
+	GLStateCache::get().bind_buffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void UniformBuffer::set_data(const void *data, size_t size, size_t offset) const
+{
+	const GLExtensions& ext = gl_extensions();
+	if (ext.direct_state_access) {
+		GL_CALL(ext.NamedBufferSubData(renderer_id, offset, size, data));
+		return;
+	}
+	bind();
+	GL_CALL(glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data));
+}
+
+unsigned int UniformBuffer::get_binding() const
+{
+	return binding;
+}
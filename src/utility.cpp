@@ -2,19 +2,21 @@
 // Created by vocasle on 11/27/21.
 //
 #include <string>
+#include <fstream>
 #include <iostream>
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
 #include "utility.h"
+#include "virtual_file_system.h"
 
 void gl_clear_error()
 {
     while (glGetError()!=GL_NO_ERROR);
 }
 
-bool gl_log_call(const std::string& function_name, const std::string& filename, unsigned int line)
+bool gl_log_call(const char* function_name, const char* filename, unsigned int line)
 {
     while (GLenum error = glGetError()) {
         std::cout << "ERROR: in "
@@ -53,11 +55,20 @@ GLFWwindow* init_gl_context(int width, int height)
         std::cerr << "Failed to initialize GLFW" << std::endl;
         return nullptr;
     }
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#if GL_CALL_CHECKS == 2
+    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GLFW_TRUE);
+#endif
 
-    GLFWwindow* window = glfwCreateWindow(width, height, "LearnOpenGL", nullptr, nullptr);
+    // 4.5 enables the direct state access paths (see gl_extensions.h), 4.3 is the minimum
+    GLFWwindow* window = nullptr;
+    for (const int minor : {5, 3}) {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, minor);
+        window = glfwCreateWindow(width, height, "LearnOpenGL", nullptr, nullptr);
+        if (window)
+            break;
+    }
     if (!window) {
         std::cerr << "Failed to create GLFW window" << std::endl;
         glfwTerminate();
@@ -70,7 +81,13 @@ GLFWwindow* init_gl_context(int width, int height)
         return nullptr;
     }
 
+#if GL_CALL_CHECKS == 2
+    gl_enable_debug_output();
+#endif
+
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    // the demos load assets by name from here on
+    VirtualFileSystem::get().mount_assets();
 
     return window;
 }
@@ -80,16 +97,6 @@ std::string format(const std::string& fmt)
     return fmt;
 }
 
-void APIENTRY gl_debug_message_callback(int source,
-                               int type,
-                               unsigned int severity,
-                               int length,
-                               const char *message,
-                               const void *user_param)
-{
-    std::cerr << "OPENGL::ERROR::" << message << std::endl;
-}
-
 void gl_print_debug_info() {
     std::cout << "OpenGL version: "
         << glGetString(GL_VERSION)
@@ -97,7 +104,3 @@ void gl_print_debug_info() {
         << glGetString(GL_VENDOR)
         << std::endl;
 }
-
-void gl_enable_debug_output() {
-    GL_CALL(glEnable(GL_DEBUG_OUTPUT));
-}
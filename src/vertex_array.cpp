@@ -1,36 +1,66 @@
 #include "vertex_array.h"
+
+#include <algorithm>
+
+#include "gl_extensions.h"
+#include "gl_state_cache.h"
 #include "utility.h"
 
 VertexArray::VertexArray(): renderer_id(0)
 {
+	const GLExtensions& ext = gl_extensions();
+	if (ext.direct_state_access) {
+		GL_CALL(ext.CreateVertexArrays(1, &renderer_id));
+		return;
+	}
 	GL_CALL(glGenVertexArrays(1, &renderer_id));
-	GL_CALL(glBindVertexArray(renderer_id));
+	GLStateCache::get().bind_vertex_array(renderer_id);
 }
 
 VertexArray::~VertexArray()
 {
 	GL_CALL(glDeleteVertexArrays(1, &renderer_id));
+	GLStateCache::get().on_vertex_array_deleted(renderer_id);
 }
 
 void VertexArray::bind() const
 {
-	GL_CALL(glBindVertexArray(renderer_id));
+	GLStateCache::get().bind_vertex_array(renderer_id);
 }
 
 void VertexArray::unbind() const
 {
-	GL_CALL(glBindVertexArray(0));
+	GLStateCache::get().bind_vertex_array(0);
+}
+
+unsigned int VertexArray::get_renderer_id() const
+{
+	return renderer_id;
 }
 
 void VertexArray::add_buffer(const VertexBuffer& vb, const VertexBufferLayout& vbl)
 {
+	if (gl_extensions().direct_state_access) {
+		// the buffer binding index follows the first location, like glVertexAttribPointer does
+		unsigned int binding = ~0u;
+		for (const VertexBufferElement &element : vbl.get_elements())
+			binding = std::min(binding, element.location);
+		if (binding != ~0u)
+			vbl.apply(renderer_id, binding, vb.get_renderer_id());
+		return;
+	}
+	bind();
 	vb.bind();
-	unsigned int offset = 0;
-	for (size_t i = 0; const auto &element : vbl.get_elements())
-	{
-		GL_CALL(glVertexAttribPointer(i, element.count, element.type, element.normalized, vbl.get_stride(), reinterpret_cast<void*>(offset)));
-		GL_CALL(glEnableVertexAttribArray(i));
-		offset += element.count * VertexBufferElement::get_type_size(element.type);
-		++i;
+	vbl.apply();
+}
+
+void VertexArray::set_index_buffer(const IndexBuffer& ib)
+{
+	const GLExtensions& ext = gl_extensions();
+	if (ext.direct_state_access) {
+		GL_CALL(ext.VertexArrayElementBuffer(renderer_id, ib.get_renderer_id()));
+		return;
 	}
+	bind();
+	ib.bind();
 }
@@ -1,26 +1,41 @@
 #include <glad/glad.h>
 
 #include "vertex_buffer.h"
+#include "gl_extensions.h"
+#include "gl_state_cache.h"
 #include "utility.h"
 
 VertexBuffer::~VertexBuffer()
 {
 	GL_CALL(glDeleteBuffers(1, &renderer_id));
+	GLStateCache::get().on_buffer_deleted(renderer_id);
 }
 
 VertexBuffer::VertexBuffer(const void* data, size_t size): renderer_id(0)
 {
+	const GLExtensions& ext = gl_extensions();
+	if (ext.direct_state_access) {
+		// immutable and never bound just to fill it
+		GL_CALL(ext.CreateBuffers(1, &renderer_id));
+		GL_CALL(ext.NamedBufferStorage(renderer_id, size, data, 0));
+		return;
+	}
 	GL_CALL(glGenBuffers(1, &renderer_id));
-	GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, renderer_id));
+	GLStateCache::get().bind_buffer(GL_ARRAY_BUFFER, renderer_id);
 	GL_CALL(glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW));
 }
 
 void VertexBuffer::bind() const
 {
-	GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, renderer_id));
+	GLStateCache::get().bind_buffer(GL_ARRAY_BUFFER, renderer_id);
 }
 
 void VertexBuffer::unbind() const
 {
-	GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, 0));
-}
\ No newline at end of file
+	GLStateCache::get().bind_buffer(GL_ARRAY_BUFFER, 0);
+}
+
+unsigned int VertexBuffer::get_renderer_id() const
+{
+	return renderer_id;
+}
@@ -1,26 +1,67 @@
 #include "vertex_buffer_layout.h"
 
+#include <algorithm>
+
+#include "gl_extensions.h"
 #include "utility.h"
 
-unsigned int VertexBufferElement::get_type_size(int i)
+unsigned int VertexBufferElement::get_type_size(unsigned int type)
 {
-	switch(i)
+	switch(type)
 	{
 	case GL_FLOAT:
-		return sizeof(float);
+	case GL_INT:
+	case GL_UNSIGNED_INT:
+		return 4;
+	case GL_HALF_FLOAT:
+	case GL_SHORT:
+	case GL_UNSIGNED_SHORT:
+		return 2;
+	case GL_BYTE:
+	case GL_UNSIGNED_BYTE:
+		return 1;
 	default:
 		return 0;
 	}
 }
 
-VertexBufferLayout::VertexBufferLayout(): elements(), stride(0)
+VertexBufferLayout::VertexBufferLayout(): elements(), stride(0), divisor(0), next_location(0)
+{
+}
+
+VertexBufferLayout::VertexBufferLayout(std::span<const VertexBufferElement> elements, unsigned int stride, unsigned int divisor):
+	elements(elements.begin(), elements.end()), stride(stride), divisor(divisor), next_location(0)
 {
+	for (const VertexBufferElement &element : elements)
+		next_location = std::max(next_location, element.location + (element.count + 3) / 4);
 }
 
 VertexBufferLayout::~VertexBufferLayout()
 {
 }
 
+void VertexBufferLayout::add(unsigned int count, unsigned int type, AttributeKind kind)
+{
+	elements.push_back({next_location, count, type, kind, stride});
+	next_location += (count + 3) / 4;
+	stride += VertexBufferElement::get_type_size(type) * count;
+}
+
+void VertexBufferLayout::add_padding(unsigned int size)
+{
+	stride += size;
+}
+
+void VertexBufferLayout::set_next_location(unsigned int location)
+{
+	next_location = location;
+}
+
+void VertexBufferLayout::set_divisor(unsigned int divisor)
+{
+	this->divisor = divisor;
+}
+
 const std::vector<VertexBufferElement>& VertexBufferLayout::get_elements() const
 {
 	return elements;
@@ -30,3 +71,52 @@ unsigned int VertexBufferLayout::get_stride() const
 {
 	return stride;
 }
+
+unsigned int VertexBufferLayout::get_divisor() const
+{
+	return divisor;
+}
+
+void VertexBufferLayout::apply(size_t base_offset) const
+{
+	const auto gl_stride = static_cast<GLsizei>(stride);
+	for (const VertexBufferElement &element : elements)
+	{
+		const unsigned int type_size = VertexBufferElement::get_type_size(element.type);
+		for (unsigned int first = 0, location = element.location; first < element.count; first += 4, ++location)
+		{
+			const auto count = static_cast<GLint>(std::min(element.count - first, 4u));
+			const auto offset = reinterpret_cast<void*>(static_cast<uintptr_t>(base_offset + element.offset + first * type_size));
+			GL_CALL(glEnableVertexAttribArray(location));
+			if (element.kind == AttributeKind::Integer)
+				GL_CALL(glVertexAttribIPointer(location, count, element.type, gl_stride, offset));
+			else
+				GL_CALL(glVertexAttribPointer(location, count, element.type,
+					element.kind == AttributeKind::Normalized ? GL_TRUE : GL_FALSE, gl_stride, offset));
+			GL_CALL(glVertexAttribDivisor(location, divisor));
+		}
+	}
+}
+
+void VertexBufferLayout::apply(unsigned int vertex_array, unsigned int binding, unsigned int buffer, size_t base_offset) const
+{
+	const GLExtensions& ext = gl_extensions();
+	GL_CALL(ext.VertexArrayVertexBuffer(vertex_array, binding, buffer, static_cast<GLintptr>(base_offset), static_cast<GLsizei>(stride)));
+	GL_CALL(ext.VertexArrayBindingDivisor(vertex_array, binding, divisor));
+	for (const VertexBufferElement &element : elements)
+	{
+		const unsigned int type_size = VertexBufferElement::get_type_size(element.type);
+		for (unsigned int first = 0, location = element.location; first < element.count; first += 4, ++location)
+		{
+			const auto count = static_cast<GLint>(std::min(element.count - first, 4u));
+			const unsigned int offset = element.offset + first * type_size;
+			GL_CALL(ext.EnableVertexArrayAttrib(vertex_array, location));
+			if (element.kind == AttributeKind::Integer)
+				GL_CALL(ext.VertexArrayAttribIFormat(vertex_array, location, count, element.type, offset));
+			else
+				GL_CALL(ext.VertexArrayAttribFormat(vertex_array, location, count, element.type,
+					element.kind == AttributeKind::Normalized ? GL_TRUE : GL_FALSE, offset));
+			GL_CALL(ext.VertexArrayAttribBinding(vertex_array, location, binding));
+		}
+	}
+}
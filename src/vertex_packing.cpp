@@ -0,0 +1,187 @@
+#include "vertex_packing.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#include "utility.h"
+
+std::uint16_t float_to_half(float value)
+{
+	const std::uint32_t bits = std::bit_cast<std::uint32_t>(value);
+	const std::uint16_t sign = static_cast<std::uint16_t>((bits >> 16) & 0x8000u);
+	const std::uint32_t abs_bits = bits & 0x7fffffffu;
+
+	// NaN stays NaN, infinity and everything too large for a half saturates to infinity
+	if (abs_bits > 0x7f800000u)
+		return sign | 0x7e00u;
+	if (abs_bits >= 0x477ff000u)
+		return sign | 0x7c00u;
+
+	// below the smallest normal half, round to a subnormal
+	if (abs_bits < 0x38800000u) {
+		const float abs_value = std::bit_cast<float>(abs_bits);
+		return sign | static_cast<std::uint16_t>(std::lrint(abs_value * 16777216.0f));
+	}
+
+	// rebias the exponent and round the mantissa to nearest even
+	const std::uint32_t rebiased = abs_bits - 0x38000000u;
+	const std::uint32_t rounded = rebiased + 0x0fffu + ((rebiased >> 13) & 1u);
+	return sign | static_cast<std::uint16_t>(rounded >> 13);
+}
+
+static std::int16_t to_snorm16(float value)
+{
+	return static_cast<std::int16_t>(std::lrint(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+static std::uint16_t to_unorm16(float value)
+{
+	return static_cast<std::uint16_t>(std::lrint(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+}
+
+static float sign_not_zero(float value)
+{
+	return value >= 0.0f ? 1.0f : -1.0f;
+}
+
+void oct_encode_snorm16(const glm::vec3 &v, std::int16_t out[2])
+{
+	const float l1 = std::abs(v.x) + std::abs(v.y) + std::abs(v.z);
+	// meshes without uvs have zero tangents, any direction will do
+	float x = l1 > 0.0f ? v.x / l1 : 0.0f;
+	float y = l1 > 0.0f ? v.y / l1 : 0.0f;
+	if (v.z < 0.0f) {
+		const float folded_x = (1.0f - std::abs(y)) * sign_not_zero(x);
+		const float folded_y = (1.0f - std::abs(x)) * sign_not_zero(y);
+		x = folded_x;
+		y = folded_y;
+	}
+	out[0] = to_snorm16(x);
+	out[1] = to_snorm16(y);
+}
+
+static bool is_skinned(std::span<const Vertex> vertices)
+{
+	for (const Vertex &vertex : vertices)
+		for (float weight : vertex.m_Weights)
+			if (weight > 0.0f)
+				return true;
+	return false;
+}
+
+PackedVertexLayout get_packed_vertex_layout(VertexFormat format, bool skinned)
+{
+	const bool quantized_positions = format == VertexFormat::CompactQuantized;
+	PackedVertexLayout layout{};
+	layout.quantized_positions = quantized_positions;
+	layout.skinned = skinned;
+	layout.position_offset = 0;
+	layout.normal_tangent_offset = quantized_positions ? 4 * sizeof(std::uint16_t) : 4 * sizeof(float);
+	layout.tex_coords_offset = layout.normal_tangent_offset + 4 * sizeof(std::int16_t);
+	layout.stride = layout.tex_coords_offset + 2 * sizeof(std::uint16_t);
+	if (skinned) {
+		layout.bone_ids_offset = layout.stride;
+		layout.weights_offset = layout.bone_ids_offset + MAX_BONE_INFLUENCE;
+		layout.stride = layout.weights_offset + MAX_BONE_INFLUENCE;
+	}
+	return layout;
+}
+
+PackedVertices pack_vertices(std::span<const Vertex> vertices, VertexFormat format)
+{
+	PackedVertices packed;
+	packed.layout = get_packed_vertex_layout(format, is_skinned(vertices));
+	packed.position_offset = glm::vec3(0.0f);
+	packed.position_scale = glm::vec3(1.0f);
+	packed.data.resize(vertices.size() * packed.layout.stride);
+
+	const PackedVertexLayout &layout = packed.layout;
+	if (layout.quantized_positions && !vertices.empty()) {
+		glm::vec3 min_position = vertices[0].Position;
+		glm::vec3 max_position = vertices[0].Position;
+		for (const Vertex &vertex : vertices) {
+			min_position = glm::min(min_position, vertex.Position);
+			max_position = glm::max(max_position, vertex.Position);
+		}
+		packed.position_offset = min_position;
+		packed.position_scale = max_position - min_position;
+	}
+
+	bool bone_ids_clamped = false;
+	for (size_t i = 0; i < vertices.size(); ++i) {
+		const Vertex &vertex = vertices[i];
+		unsigned char *out = packed.data.data() + i * layout.stride;
+
+		const float bitangent_sign = glm::dot(glm::cross(vertex.Normal, vertex.Tangent), vertex.Bitangent) < 0.0f ? 0.0f : 1.0f;
+		if (layout.quantized_positions) {
+			std::uint16_t position[4];
+			for (int c = 0; c < 3; ++c) {
+				const float extent = packed.position_scale[c];
+				position[c] = to_unorm16(extent > 0.0f ? (vertex.Position[c] - packed.position_offset[c]) / extent : 0.0f);
+			}
+			position[3] = to_unorm16(bitangent_sign);
+			std::memcpy(out + layout.position_offset, position, sizeof(position));
+		}
+		else {
+			const float position[4] = {vertex.Position.x, vertex.Position.y, vertex.Position.z, bitangent_sign};
+			std::memcpy(out + layout.position_offset, position, sizeof(position));
+		}
+
+		std::int16_t normal_tangent[4];
+		oct_encode_snorm16(vertex.Normal, normal_tangent);
+		oct_encode_snorm16(vertex.Tangent, normal_tangent + 2);
+		std::memcpy(out + layout.normal_tangent_offset, normal_tangent, sizeof(normal_tangent));
+
+		const std::uint16_t tex_coords[2] = {float_to_half(vertex.TexCoords.x), float_to_half(vertex.TexCoords.y)};
+		std::memcpy(out + layout.tex_coords_offset, tex_coords, sizeof(tex_coords));
+
+		if (layout.skinned) {
+			for (int b = 0; b < MAX_BONE_INFLUENCE; ++b) {
+				const int bone_id = vertex.m_BoneIDs[b];
+				bone_ids_clamped |= bone_id < 0 || bone_id > 255;
+				out[layout.bone_ids_offset + b] = static_cast<unsigned char>(std::clamp(bone_id, 0, 255));
+				out[layout.weights_offset + b] = static_cast<unsigned char>(std::lrint(std::clamp(vertex.m_Weights[b], 0.0f, 1.0f) * 255.0f));
+			}
+		}
+	}
+
+	if (bone_ids_clamped)
+		std::cerr << "Bone ids outside of 0..255 were clamped while packing vertices" << std::endl;
+	return packed;
+}
+
+VertexBufferLayout get_vertex_buffer_layout(const PackedVertexLayout &layout)
+{
+	std::vector<VertexBufferElement> elements;
+	if (layout.quantized_positions)
+		elements.push_back({0, 4, GL_UNSIGNED_SHORT, AttributeKind::Normalized, layout.position_offset});
+	else
+		elements.push_back({0, 4, GL_FLOAT, AttributeKind::Float, layout.position_offset});
+	elements.push_back({1, 4, GL_SHORT, AttributeKind::Normalized, layout.normal_tangent_offset});
+	elements.push_back({2, 2, GL_HALF_FLOAT, AttributeKind::Float, layout.tex_coords_offset});
+	if (layout.skinned) {
+		elements.push_back({5, MAX_BONE_INFLUENCE, GL_UNSIGNED_BYTE, AttributeKind::Integer, layout.bone_ids_offset});
+		elements.push_back({6, MAX_BONE_INFLUENCE, GL_UNSIGNED_BYTE, AttributeKind::Normalized, layout.weights_offset});
+	}
+	return VertexBufferLayout(elements, layout.stride);
+}
+
+static constexpr VertexBufferElement FULL_VERTEX_ELEMENTS[] = {
+	VERTEX_ELEMENT(0, Vertex, Position, float, AttributeKind::Float),
+	VERTEX_ELEMENT(1, Vertex, Normal, float, AttributeKind::Float),
+	VERTEX_ELEMENT(2, Vertex, TexCoords, float, AttributeKind::Float),
+	VERTEX_ELEMENT(3, Vertex, Tangent, float, AttributeKind::Float),
+	VERTEX_ELEMENT(4, Vertex, Bitangent, float, AttributeKind::Float),
+	VERTEX_ELEMENT(5, Vertex, m_BoneIDs, int, AttributeKind::Integer),
+	VERTEX_ELEMENT(6, Vertex, m_Weights, float, AttributeKind::Float),
+};
+
+VertexBufferLayout get_full_vertex_buffer_layout()
+{
+	return VertexBufferLayout(FULL_VERTEX_ELEMENTS, sizeof(Vertex));
+}
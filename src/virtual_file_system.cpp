@@ -0,0 +1,180 @@
+#include "virtual_file_system.h"
+
+#include <filesystem>
+#include <iostream>
+#include <system_error>
+#include <utility>
+
+#include "lz4_block.h"
+
+namespace fs = std::filesystem;
+
+AssetFile::AssetFile(AssetFile &&other) noexcept:
+	mapping(std::move(other.mapping)),
+	inflated(std::move(other.inflated)),
+	data(std::exchange(other.data, nullptr)),
+	size(std::exchange(other.size, 0)),
+	opened(std::exchange(other.opened, false))
+{
+}
+
+AssetFile& AssetFile::operator=(AssetFile &&other) noexcept
+{
+	if (this != &other) {
+		mapping = std::move(other.mapping);
+		inflated = std::move(other.inflated);
+		data = std::exchange(other.data, nullptr);
+		size = std::exchange(other.size, 0);
+		opened = std::exchange(other.opened, false);
+	}
+	return *this;
+}
+
+void AssetFile::close()
+{
+	mapping.close();
+	inflated = {};
+	data = nullptr;
+	size = 0;
+	opened = false;
+}
+
+bool AssetFile::is_open() const
+{
+	return opened;
+}
+
+const unsigned char* AssetFile::get_data() const
+{
+	return data;
+}
+
+size_t AssetFile::get_size() const
+{
+	return size;
+}
+
+// names are looked up the way the packer stores them
+static std::string normalize_name(const std::string &name)
+{
+	return fs::path(name).lexically_normal().generic_string();
+}
+
+VirtualFileSystem& VirtualFileSystem::get()
+{
+	static VirtualFileSystem file_system;
+	return file_system;
+}
+
+bool VirtualFileSystem::mount_archive(const std::string &path)
+{
+	auto archive = std::make_unique<AssetArchive>();
+	if (!archive->open(path))
+		return false;
+	mounts.push_back({std::move(archive), {}});
+	return true;
+}
+
+bool VirtualFileSystem::mount_directory(const std::string &path)
+{
+	std::error_code error;
+	if (!fs::is_directory(path, error))
+		return false;
+	mounts.push_back({nullptr, path});
+	return true;
+}
+
+bool VirtualFileSystem::mount_assets()
+{
+	fs::path directory = ".";
+	for (int depth = 0; depth < 4; ++depth, directory /= "..") {
+		std::error_code error;
+		const fs::path archive = directory / "assets.pak";
+		const bool has_archive = fs::is_regular_file(archive, error);
+		const bool has_directory = fs::is_directory(directory / "assets", error);
+		if (!has_archive && !has_directory)
+			continue;
+
+		bool mounted = has_archive && mount_archive(archive.lexically_normal().string());
+		if (has_directory)
+			mounted = mount_directory((directory / "assets").lexically_normal().string()) || mounted;
+		return mounted;
+	}
+	std::cerr << "No assets.pak or assets directory found from " << fs::current_path().string() << std::endl;
+	return false;
+}
+
+void VirtualFileSystem::unmount_all()
+{
+	mounts.clear();
+}
+
+bool VirtualFileSystem::open(const std::string &name, AssetFile &file, MappedFile::Access access) const
+{
+	file.close();
+	const std::string normalized = normalize_name(name);
+	for (const Mount &mount : mounts) {
+		if (!mount.archive) {
+			if (file.mapping.open((fs::path(mount.directory) / normalized).string(), access))
+				break;
+			continue;
+		}
+
+		const AssetArchiveEntry *entry = mount.archive->find(normalized);
+		if (!entry)
+			continue;
+		const unsigned char *stored = mount.archive->get_data(*entry);
+		if (entry->compression == AssetCompression::None) {
+			if (access == MappedFile::Access::WillNeed)
+				mount.archive->prefetch(*entry);
+			file.data = stored;
+			file.size = static_cast<size_t>(entry->size);
+			file.opened = true;
+			return true;
+		}
+
+		file.inflated.resize(static_cast<size_t>(entry->decompressed_size));
+		if (!lz4_decompress(stored, static_cast<size_t>(entry->size), file.inflated.data(), file.inflated.size())) {
+			std::cerr << "Asset archive " << mount.archive->get_path() << " entry " << normalized << " is corrupt" << std::endl;
+			file.close();
+			return false;
+		}
+		file.data = file.inflated.data();
+		file.size = file.inflated.size();
+		file.opened = true;
+		return true;
+	}
+
+	if (!file.mapping.is_open() && !file.mapping.open(name, access))
+		return false;
+	file.data = file.mapping.get_data();
+	file.size = file.mapping.get_size();
+	file.opened = true;
+	return true;
+}
+
+bool VirtualFileSystem::exists(const std::string &name) const
+{
+	const std::string normalized = normalize_name(name);
+	std::error_code error;
+	for (const Mount &mount : mounts) {
+		if (mount.archive ? mount.archive->find(normalized) != nullptr
+			: fs::is_regular_file(fs::path(mount.directory) / normalized, error))
+			return true;
+	}
+	return fs::is_regular_file(name, error);
+}
+
+std::string VirtualFileSystem::resolve(const std::string &name) const
+{
+	const std::string normalized = normalize_name(name);
+	std::error_code error;
+	for (const Mount &mount : mounts) {
+		if (mount.archive)
+			continue;
+		const fs::path path = fs::path(mount.directory) / normalized;
+		if (fs::is_regular_file(path, error))
+			return path.string();
+	}
+	return name;
+}
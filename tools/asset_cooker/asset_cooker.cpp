@@ -0,0 +1,339 @@
+//
+// Cooks an asset directory into the runtime ready files the demos load,
+// mirroring its layout in the output directory:
+//	models (obj, fbx, gltf, ...) -> <model>.meshcache, imported and optimized,
+//	                                the model file itself is not copied
+//	images (png, jpg, tga, bmp)  -> <image>.dds, see texture_encoding.h, and
+//	                                the image itself for code that decodes
+//	                                it or drivers without the block format
+//	anything else                -> copied as is
+// Model, Texture and TextureRegistry find the cooked files under the names
+// of the sources, so the demos keep their paths.
+//
+//	asset_cooker [--bc7] [--srgb] [--flip <directory>]... [--force] <assets> <output>
+//
+// --flip cooks the images below an asset directory bottom up, for the demos
+// that call stbi_set_flip_vertically_on_load(true) on them.
+//
+// Rebuilds are incremental: the output directory keeps a manifest with the
+// content hash and recipe of every cooked source, only sources whose hash
+// or recipe changed are cooked again and outputs of removed sources are
+// deleted. Sources are cooked concurrently. A source that fails to cook is
+// copied as is, so the demos fall back to loading it the slow way.
+//
+
+#include <algorithm>
+#include <cctype>
+#include <cinttypes>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+#include "content_hash.h"
+#include "mesh_cache.h"
+#include "mesh_import.h"
+#include "texture_encoding.h"
+#include "thread_pool.h"
+
+namespace fs = std::filesystem;
+
+// bump when the cooked output of an unchanged source changes, forces a full rebuild
+static constexpr int COOKER_VERSION = 2;
+static constexpr const char *MANIFEST_NAME = ".asset_cooker_manifest";
+
+enum class CookKind {
+	Mesh,
+	Texture,
+	Copy,
+};
+
+struct CookerOptions {
+	TextureEncodingOptions texture;
+	// asset directories whose images are flipped, relative to the asset root
+	std::vector<std::string> flip_directories;
+	bool force = false;
+};
+
+struct ManifestEntry {
+	std::uint64_t hash;
+	std::string recipe;
+};
+
+struct CookJob {
+	// relative to the asset root, generic separators
+	std::string path;
+	CookKind kind;
+	std::string recipe;
+	std::uint64_t hash;
+	bool hashed;
+	bool cook;
+	bool succeeded;
+};
+
+static std::string to_lower(std::string text)
+{
+	std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	return text;
+}
+
+static bool is_model_source(const fs::path &path)
+{
+	static const char *extensions[] = {".obj", ".fbx", ".gltf", ".glb", ".dae", ".3ds", ".blend", ".ply", ".stl"};
+	const std::string extension = to_lower(path.extension().string());
+	return std::find(std::begin(extensions), std::end(extensions), extension) != std::end(extensions);
+}
+
+static bool is_flipped(const std::string &path, const CookerOptions &options)
+{
+	return std::any_of(options.flip_directories.begin(), options.flip_directories.end(), [&](const std::string &directory) {
+		return path.size() > directory.size() && path.compare(0, directory.size(), directory) == 0 && path[directory.size()] == '/';
+	});
+}
+
+static CookKind get_cook_kind(const fs::path &root, const std::string &path)
+{
+	const fs::path source = root / path;
+	if (is_model_source(source))
+		return CookKind::Mesh;
+	if (is_texture_source(source)) {
+		// a compressed file shipped next to the image wins, it is copied and the image left alone
+		std::error_code error;
+		for (const char *extension : {".dds", ".ktx2"}) {
+			if (fs::exists(fs::path(source).replace_extension(extension), error))
+				return CookKind::Copy;
+		}
+		return CookKind::Texture;
+	}
+	return CookKind::Copy;
+}
+
+static std::string get_recipe(CookKind kind, const std::string &path, const CookerOptions &options)
+{
+	switch (kind) {
+	case CookKind::Mesh:
+		return "mesh+optimized";
+	case CookKind::Texture: {
+		std::string recipe = "texture";
+		if (options.texture.bc7)
+			recipe += "+bc7";
+		if (options.texture.srgb)
+			recipe += "+srgb";
+		if (is_flipped(path, options))
+			recipe += "+flip";
+		return recipe;
+	}
+	default:
+		return "copy";
+	}
+}
+
+// the first one is what the recipe cooks, a texture ships its source image as well
+static std::vector<fs::path> get_output_paths(const fs::path &output, const std::string &path, const std::string &recipe)
+{
+	if (recipe.rfind("mesh", 0) == 0)
+		return {get_mesh_cache_path((output / path).string())};
+	if (recipe.rfind("texture", 0) == 0)
+		return {(output / path).replace_extension(".dds"), output / path};
+	return {output / path};
+}
+
+static std::unordered_map<std::string, ManifestEntry> read_manifest(const fs::path &manifest_path)
+{
+	std::unordered_map<std::string, ManifestEntry> entries;
+	std::ifstream file(manifest_path);
+	std::string line;
+	if (!std::getline(file, line) || line != "asset_cooker " + std::to_string(COOKER_VERSION))
+		return entries;
+
+	// <hash> <recipe> <path>, the path goes last since it may contain spaces
+	while (std::getline(file, line)) {
+		std::istringstream fields(line);
+		std::string hash, recipe, path;
+		if (!(fields >> hash >> recipe) || !std::getline(fields >> std::ws, path))
+			continue;
+		entries[path] = {std::stoull(hash, nullptr, 16), recipe};
+	}
+	return entries;
+}
+
+static bool write_manifest(const fs::path &manifest_path, const std::vector<CookJob> &jobs)
+{
+	std::ofstream file(manifest_path, std::ios::trunc);
+	file << "asset_cooker " << COOKER_VERSION << "\n";
+	for (const CookJob &job : jobs) {
+		if (!job.succeeded)
+			continue;
+		char hash[17];
+		std::snprintf(hash, sizeof(hash), "%016" PRIx64, job.hash);
+		file << hash << ' ' << job.recipe << ' ' << job.path << "\n";
+	}
+	return static_cast<bool>(file);
+}
+
+static bool cook(const fs::path &root, const fs::path &output, const CookJob &job, const CookerOptions &options, std::mutex &log_mutex)
+{
+	const fs::path source = root / job.path;
+	const fs::path destination = get_output_paths(output, job.path, job.recipe).front();
+	std::ostringstream log;
+	bool cooked = false;
+	switch (job.kind) {
+	case CookKind::Mesh:
+		cooked = cook_meshes(source.string(), destination.string(), true);
+		log << job.path << " -> " << destination.filename().string();
+		break;
+	case CookKind::Texture: {
+		TextureEncodingOptions texture = options.texture;
+		texture.flip = is_flipped(job.path, options);
+		EncodedTexture encoded;
+		// the blocks go to the shared pool, the cooker's own workers are busy with whole files
+		cooked = encode_texture(ThreadPool::shared(), source, destination, texture, encoded);
+		if (cooked) {
+			std::error_code error;
+			cooked = fs::copy_file(source, output / job.path, fs::copy_options::overwrite_existing, error);
+			if (!cooked)
+				std::cerr << "Failed to copy " << source.string() << ": " << error.message() << std::endl;
+		}
+		if (cooked)
+			log << job.path << " -> " << destination.filename().string() << " (" << get_block_format_name(encoded.format)
+				<< ", " << encoded.uncompressed_size / 1024 << " KiB -> " << encoded.compressed_size / 1024 << " KiB)";
+		break;
+	}
+	case CookKind::Copy: {
+		std::error_code error;
+		cooked = fs::copy_file(source, destination, fs::copy_options::overwrite_existing, error);
+		if (!cooked)
+			std::cerr << "Failed to copy " << source.string() << ": " << error.message() << std::endl;
+		log << job.path << " copied";
+		break;
+	}
+	}
+
+	if (cooked) {
+		std::lock_guard lock(log_mutex);
+		std::cout << log.str() << std::endl;
+	}
+	return cooked;
+}
+
+int main(int argc, char **argv)
+{
+	CookerOptions options;
+	std::vector<fs::path> directories;
+	for (int i = 1; i < argc; ++i) {
+		const std::string argument = argv[i];
+		if (argument == "--bc7")
+			options.texture.bc7 = true;
+		else if (argument == "--srgb")
+			options.texture.srgb = true;
+		else if (argument == "--force")
+			options.force = true;
+		else if (argument == "--flip" && i + 1 < argc)
+			options.flip_directories.push_back(fs::path(argv[++i]).lexically_normal().generic_string());
+		else if (argument.rfind("--", 0) == 0) {
+			std::cerr << "Unknown option " << argument << std::endl;
+			return 1;
+		}
+		else
+			directories.emplace_back(argument);
+	}
+	if (directories.size() != 2) {
+		std::cerr << "usage: asset_cooker [--bc7] [--srgb] [--flip <directory>]... [--force] <assets> <output>" << std::endl;
+		return 1;
+	}
+
+	const fs::path &root = directories[0];
+	const fs::path &output = directories[1];
+	std::error_code error;
+	if (!fs::is_directory(root, error)) {
+		std::cerr << "No such asset directory " << root.string() << std::endl;
+		return 1;
+	}
+	fs::create_directories(output, error);
+
+	std::vector<CookJob> jobs;
+	for (const fs::directory_entry &entry : fs::recursive_directory_iterator(root, error)) {
+		if (!entry.is_regular_file(error))
+			continue;
+		const std::string path = fs::relative(entry.path(), root, error).generic_string();
+		// caches Model wrote next to a source, the cooked one replaces them
+		if (to_lower(entry.path().extension().string()) == ".meshcache")
+			continue;
+		const CookKind kind = get_cook_kind(root, path);
+		jobs.push_back({path, kind, get_recipe(kind, path, options), 0, false, false, false});
+	}
+	std::sort(jobs.begin(), jobs.end(), [](const CookJob &a, const CookJob &b) { return a.path < b.path; });
+
+	const fs::path manifest_path = output / MANIFEST_NAME;
+	std::unordered_map<std::string, ManifestEntry> manifest = read_manifest(manifest_path);
+
+	ThreadPool pool;
+	pool.parallel_for(jobs.size(), [&](size_t i) {
+		CookJob &job = jobs[i];
+		job.hashed = hash_file((root / job.path).string(), job.hash);
+		const auto it = manifest.find(job.path);
+		const std::vector<fs::path> outputs = get_output_paths(output, job.path, job.recipe);
+		job.cook = options.force || !job.hashed || it == manifest.end()
+			|| it->second.hash != job.hash || it->second.recipe != job.recipe
+			|| std::any_of(outputs.begin(), outputs.end(), [](const fs::path &path) {
+				std::error_code exists_error;
+				return !fs::exists(path, exists_error);
+			});
+		job.succeeded = !job.cook;
+	});
+
+	// outputs of sources that are gone or now cook into different files
+	unsigned int removed = 0;
+	for (const auto &[path, entry] : manifest) {
+		const auto job = std::find_if(jobs.begin(), jobs.end(), [&](const CookJob &j) { return j.path == path; });
+		const std::vector<fs::path> current = job == jobs.end() ? std::vector<fs::path>{} : get_output_paths(output, path, job->recipe);
+		for (const fs::path &stale : get_output_paths(output, path, entry.recipe)) {
+			if (std::find(current.begin(), current.end(), stale) == current.end())
+				removed += fs::remove(stale, error) ? 1 : 0;
+		}
+	}
+
+	for (const CookJob &job : jobs) {
+		if (job.cook)
+			fs::create_directories((output / job.path).parent_path(), error);
+	}
+
+	std::mutex log_mutex;
+	unsigned int failed = 0;
+	unsigned int unrecoverable = 0;
+	std::mutex count_mutex;
+	pool.parallel_for(jobs.size(), [&](size_t i) {
+		CookJob &job = jobs[i];
+		if (!job.cook)
+			return;
+		job.succeeded = job.hashed && cook(root, output, job, options, log_mutex);
+		if (job.succeeded)
+			return;
+
+		std::error_code copy_error;
+		const bool copied = fs::copy_file(root / job.path, output / job.path, fs::copy_options::overwrite_existing, copy_error);
+		std::lock_guard lock(count_mutex);
+		++failed;
+		if (!copied) {
+			std::cerr << "Failed to cook or copy " << job.path << std::endl;
+			++unrecoverable;
+		}
+		else
+			std::cerr << "Failed to cook " << job.path << ", copied it as is" << std::endl;
+	});
+
+	const auto cooked = static_cast<unsigned int>(std::count_if(jobs.begin(), jobs.end(), [](const CookJob &job) { return job.cook; }));
+	if (!write_manifest(manifest_path, jobs)) {
+		std::cerr << "Failed to write " << manifest_path.string() << std::endl;
+		return 1;
+	}
+	std::cout << "asset_cooker: " << cooked - failed << " cooked, " << jobs.size() - cooked << " up to date, "
+		<< failed << " failed, " << removed << " removed" << std::endl;
+	return unrecoverable > 0 ? 1 : 0;
+}
@@ -0,0 +1,66 @@
+//
+// Packs a directory, normally the output of asset_cooker, into an asset
+// archive (see asset_archive.h) that VirtualFileSystem::mount_assets picks
+// up in place of the loose files.
+//
+//	asset_packer [--lz4] <directory> <archive>
+//
+// Files are packed in path order, which keeps the files of one model next
+// to each other. Hidden files, like the cooker's manifest, are left out.
+// --lz4 compresses the entries that shrink by at least a quarter, mostly
+// mesh caches; the rest stay uncompressed so they are used in place.
+//
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "asset_archive.h"
+
+namespace fs = std::filesystem;
+
+int main(int argc, char **argv)
+{
+	bool compress = false;
+	std::vector<std::string> arguments;
+	for (int i = 1; i < argc; ++i) {
+		const std::string argument = argv[i];
+		if (argument == "--lz4")
+			compress = true;
+		else if (argument.rfind("--", 0) == 0) {
+			std::cerr << "Unknown option " << argument << std::endl;
+			return 1;
+		}
+		else
+			arguments.push_back(argument);
+	}
+	if (arguments.size() != 2) {
+		std::cerr << "usage: asset_packer [--lz4] <directory> <archive>" << std::endl;
+		return 1;
+	}
+
+	const fs::path root = arguments[0];
+	std::error_code error;
+	if (!fs::is_directory(root, error)) {
+		std::cerr << "No such directory " << root.string() << std::endl;
+		return 1;
+	}
+
+	std::vector<AssetArchiveSource> sources;
+	for (const fs::directory_entry &entry : fs::recursive_directory_iterator(root, error)) {
+		if (!entry.is_regular_file(error) || entry.path().filename().string().front() == '.')
+			continue;
+		sources.push_back({fs::relative(entry.path(), root, error).generic_string(), entry.path().string()});
+	}
+	std::sort(sources.begin(), sources.end(), [](const AssetArchiveSource &a, const AssetArchiveSource &b) { return a.name < b.name; });
+
+	AssetArchiveStats stats;
+	if (!write_asset_archive(arguments[1], sources, compress, stats))
+		return 1;
+	std::cout << "asset_packer: " << stats.entry_count << " files, " << stats.compressed_count << " compressed, "
+		<< stats.source_size / 1024 << " KiB -> " << stats.archive_size / 1024 << " KiB" << std::endl;
+	return 0;
+}
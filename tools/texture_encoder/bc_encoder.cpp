@@ -0,0 +1,377 @@
+#include "bc_encoder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+static constexpr int PIXEL_COUNT = 16;
+
+struct Color {
+	float c[4];
+};
+
+// weights of the second endpoint for the 16 BC7 indices, out of 64
+static constexpr int BC7_WEIGHTS[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+static void load_block(const unsigned char *rgba, Color *pixels)
+{
+	for (int i = 0; i < PIXEL_COUNT; ++i) {
+		for (int k = 0; k < 4; ++k)
+			pixels[i].c[k] = rgba[i * 4 + k];
+	}
+}
+
+static float distance(const Color &a, const Color &b, int channels)
+{
+	float d = 0.0f;
+	for (int k = 0; k < channels; ++k)
+		d += (a.c[k] - b.c[k]) * (a.c[k] - b.c[k]);
+	return d;
+}
+
+// end points of the segment along the direction of largest variance that covers every pixel
+static void fit_principal_axis(const Color *pixels, int channels, Color &start, Color &end)
+{
+	Color mean{};
+	for (int i = 0; i < PIXEL_COUNT; ++i) {
+		for (int k = 0; k < channels; ++k)
+			mean.c[k] += pixels[i].c[k] / PIXEL_COUNT;
+	}
+
+	float covariance[4][4] = {};
+	for (int i = 0; i < PIXEL_COUNT; ++i) {
+		for (int a = 0; a < channels; ++a) {
+			for (int b = 0; b < channels; ++b)
+				covariance[a][b] += (pixels[i].c[a] - mean.c[a]) * (pixels[i].c[b] - mean.c[b]);
+		}
+	}
+
+	// power iteration, converges quickly for the dominant eigenvector
+	float axis[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+	for (int iteration = 0; iteration < 8; ++iteration) {
+		float next[4] = {};
+		float length = 0.0f;
+		for (int a = 0; a < channels; ++a) {
+			for (int b = 0; b < channels; ++b)
+				next[a] += covariance[a][b] * axis[b];
+			length = std::max(length, std::abs(next[a]));
+		}
+		if (length < 1e-6f) {
+			// flat block, every pixel is the mean
+			start = mean;
+			end = mean;
+			return;
+		}
+		for (int a = 0; a < channels; ++a)
+			axis[a] = next[a] / length;
+	}
+
+	float min_t = 0.0f;
+	float max_t = 0.0f;
+	float axis_length = 0.0f;
+	for (int a = 0; a < channels; ++a)
+		axis_length += axis[a] * axis[a];
+	for (int i = 0; i < PIXEL_COUNT; ++i) {
+		float t = 0.0f;
+		for (int k = 0; k < channels; ++k)
+			t += (pixels[i].c[k] - mean.c[k]) * axis[k];
+		t /= axis_length;
+		min_t = std::min(min_t, t);
+		max_t = std::max(max_t, t);
+	}
+
+	for (int k = 0; k < channels; ++k) {
+		start.c[k] = std::clamp(mean.c[k] + axis[k] * min_t, 0.0f, 255.0f);
+		end.c[k] = std::clamp(mean.c[k] + axis[k] * max_t, 0.0f, 255.0f);
+	}
+}
+
+// least squares endpoints for the given weights of end (0 to 1) per pixel,
+// false when the weights do not determine them
+static bool refit_endpoints(const Color *pixels, const float *weights, int channels, Color &start, Color &end)
+{
+	float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+	Color ax{}, bx{};
+	for (int i = 0; i < PIXEL_COUNT; ++i) {
+		const float b = weights[i];
+		const float a = 1.0f - b;
+		aa += a * a;
+		ab += a * b;
+		bb += b * b;
+		for (int k = 0; k < channels; ++k) {
+			ax.c[k] += a * pixels[i].c[k];
+			bx.c[k] += b * pixels[i].c[k];
+		}
+	}
+
+	const float determinant = aa * bb - ab * ab;
+	if (std::abs(determinant) < 1e-6f)
+		return false;
+	for (int k = 0; k < channels; ++k) {
+		start.c[k] = std::clamp((bb * ax.c[k] - ab * bx.c[k]) / determinant, 0.0f, 255.0f);
+		end.c[k] = std::clamp((aa * bx.c[k] - ab * ax.c[k]) / determinant, 0.0f, 255.0f);
+	}
+	return true;
+}
+
+// index of the palette entry closest to each pixel, returns the total squared error
+static float choose_indices(const Color *pixels, const Color *palette, int palette_size, int channels, int *indices)
+{
+	float total = 0.0f;
+	for (int i = 0; i < PIXEL_COUNT; ++i) {
+		float best = distance(pixels[i], palette[0], channels);
+		indices[i] = 0;
+		for (int p = 1; p < palette_size; ++p) {
+			const float d = distance(pixels[i], palette[p], channels);
+			if (d < best) {
+				best = d;
+				indices[i] = p;
+			}
+		}
+		total += best;
+	}
+	return total;
+}
+
+// BC1
+
+static std::uint16_t pack_565(const Color &color)
+{
+	const auto r = static_cast<std::uint16_t>(std::lround(color.c[0] * 31.0f / 255.0f));
+	const auto g = static_cast<std::uint16_t>(std::lround(color.c[1] * 63.0f / 255.0f));
+	const auto b = static_cast<std::uint16_t>(std::lround(color.c[2] * 31.0f / 255.0f));
+	return static_cast<std::uint16_t>(r << 11 | g << 5 | b);
+}
+
+static Color unpack_565(std::uint16_t packed)
+{
+	const int r = packed >> 11 & 31;
+	const int g = packed >> 5 & 63;
+	const int b = packed & 31;
+	return {{float(r << 3 | r >> 2), float(g << 2 | g >> 4), float(b << 3 | b >> 2), 255.0f}};
+}
+
+// four colour palette of two packed endpoints, in index order
+static void make_bc1_palette(std::uint16_t color0, std::uint16_t color1, Color *palette)
+{
+	palette[0] = unpack_565(color0);
+	palette[1] = unpack_565(color1);
+	for (int k = 0; k < 3; ++k) {
+		palette[2].c[k] = std::floor((2.0f * palette[0].c[k] + palette[1].c[k]) / 3.0f);
+		palette[3].c[k] = std::floor((palette[0].c[k] + 2.0f * palette[1].c[k]) / 3.0f);
+	}
+}
+
+static void encode_bc1_colors(const Color *pixels, unsigned char *block)
+{
+	// weight of color1 for each index
+	static constexpr float INDEX_WEIGHTS[4] = {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+
+	Color start, end;
+	fit_principal_axis(pixels, 3, start, end);
+
+	std::uint16_t color0 = 0, color1 = 0;
+	int indices[PIXEL_COUNT] = {};
+	float best_error = -1.0f;
+	for (int pass = 0; pass < 2; ++pass) {
+		const std::uint16_t c0 = pack_565(end);
+		const std::uint16_t c1 = pack_565(start);
+		Color palette[4];
+		make_bc1_palette(c0, c1, palette);
+		int candidate[PIXEL_COUNT];
+		const float error = choose_indices(pixels, palette, 4, 3, candidate);
+		if (best_error < 0.0f || error < best_error) {
+			best_error = error;
+			color0 = c0;
+			color1 = c1;
+			std::copy(candidate, candidate + PIXEL_COUNT, indices);
+		}
+
+		float weights[PIXEL_COUNT];
+		for (int i = 0; i < PIXEL_COUNT; ++i)
+			weights[i] = 1.0f - INDEX_WEIGHTS[candidate[i]];
+		if (!refit_endpoints(pixels, weights, 3, start, end))
+			break;
+	}
+
+	// color0 > color1 selects four colour mode, equal endpoints only ever use index 0
+	if (color0 < color1) {
+		std::swap(color0, color1);
+		for (int &index : indices)
+			index ^= 1;
+	}
+	else if (color0 == color1)
+		std::fill(indices, indices + PIXEL_COUNT, 0);
+
+	std::uint32_t bits = 0;
+	for (int i = 0; i < PIXEL_COUNT; ++i)
+		bits |= static_cast<std::uint32_t>(indices[i]) << (2 * i);
+
+	block[0] = static_cast<unsigned char>(color0);
+	block[1] = static_cast<unsigned char>(color0 >> 8);
+	block[2] = static_cast<unsigned char>(color1);
+	block[3] = static_cast<unsigned char>(color1 >> 8);
+	for (int i = 0; i < 4; ++i)
+		block[4 + i] = static_cast<unsigned char>(bits >> (8 * i));
+}
+
+// BC4, one channel
+
+static void encode_bc4(const unsigned char *rgba, int channel, unsigned char *block)
+{
+	int low = 255, high = 0;
+	for (int i = 0; i < PIXEL_COUNT; ++i) {
+		low = std::min<int>(low, rgba[i * 4 + channel]);
+		high = std::max<int>(high, rgba[i * 4 + channel]);
+	}
+
+	// high > low selects the eight value mode, the palette runs from high to low
+	int palette[8] = {high, low};
+	for (int p = 2; p < 8; ++p)
+		palette[p] = ((8 - p) * high + (p - 1) * low) / 7;
+
+	std::uint64_t bits = 0;
+	if (high != low) {
+		for (int i = 0; i < PIXEL_COUNT; ++i) {
+			const int value = rgba[i * 4 + channel];
+			int best = 0;
+			for (int p = 1; p < 8; ++p) {
+				if (std::abs(palette[p] - value) < std::abs(palette[best] - value))
+					best = p;
+			}
+			bits |= static_cast<std::uint64_t>(best) << (3 * i);
+		}
+	}
+
+	block[0] = static_cast<unsigned char>(high);
+	block[1] = static_cast<unsigned char>(low);
+	for (int i = 0; i < 6; ++i)
+		block[2 + i] = static_cast<unsigned char>(bits >> (8 * i));
+}
+
+void encode_bc1(const unsigned char *rgba, unsigned char *block)
+{
+	Color pixels[PIXEL_COUNT];
+	load_block(rgba, pixels);
+	encode_bc1_colors(pixels, block);
+}
+
+void encode_bc3(const unsigned char *rgba, unsigned char *block)
+{
+	encode_bc4(rgba, 3, block);
+	Color pixels[PIXEL_COUNT];
+	load_block(rgba, pixels);
+	encode_bc1_colors(pixels, block + 8);
+}
+
+void encode_bc5(const unsigned char *rgba, unsigned char *block)
+{
+	encode_bc4(rgba, 0, block);
+	encode_bc4(rgba, 1, block + 8);
+}
+
+// BC7 mode 6
+
+struct Bc7Endpoint {
+	int q[4];
+	int p;
+};
+
+// 7 bit endpoint plus the shared p-bit closest to color
+static Bc7Endpoint quantize_bc7(const Color &color)
+{
+	Bc7Endpoint best{};
+	float best_error = -1.0f;
+	for (int p = 0; p < 2; ++p) {
+		Bc7Endpoint candidate{{}, p};
+		float error = 0.0f;
+		for (int k = 0; k < 4; ++k) {
+			candidate.q[k] = std::clamp(static_cast<int>(std::lround((color.c[k] - p) / 2.0f)), 0, 127);
+			const float value = static_cast<float>(candidate.q[k] << 1 | p);
+			error += (value - color.c[k]) * (value - color.c[k]);
+		}
+		if (best_error < 0.0f || error < best_error) {
+			best_error = error;
+			best = candidate;
+		}
+	}
+	return best;
+}
+
+static void make_bc7_palette(const Bc7Endpoint &e0, const Bc7Endpoint &e1, Color *palette)
+{
+	for (int i = 0; i < 16; ++i) {
+		for (int k = 0; k < 4; ++k) {
+			const int a = e0.q[k] << 1 | e0.p;
+			const int b = e1.q[k] << 1 | e1.p;
+			palette[i].c[k] = static_cast<float>(((64 - BC7_WEIGHTS[i]) * a + BC7_WEIGHTS[i] * b + 32) >> 6);
+		}
+	}
+}
+
+struct BitWriter {
+	unsigned char *out;
+	unsigned int position;
+
+	void write(unsigned int value, unsigned int bits)
+	{
+		for (unsigned int i = 0; i < bits; ++i, ++position) {
+			if (value >> i & 1)
+				out[position / 8] |= static_cast<unsigned char>(1 << (position % 8));
+		}
+	}
+};
+
+void encode_bc7(const unsigned char *rgba, unsigned char *block)
+{
+	Color pixels[PIXEL_COUNT];
+	load_block(rgba, pixels);
+
+	Color start, end;
+	fit_principal_axis(pixels, 4, start, end);
+
+	Bc7Endpoint e0{}, e1{};
+	int indices[PIXEL_COUNT] = {};
+	float best_error = -1.0f;
+	for (int pass = 0; pass < 2; ++pass) {
+		const Bc7Endpoint q0 = quantize_bc7(start);
+		const Bc7Endpoint q1 = quantize_bc7(end);
+		Color palette[16];
+		make_bc7_palette(q0, q1, palette);
+		int candidate[PIXEL_COUNT];
+		const float error = choose_indices(pixels, palette, 16, 4, candidate);
+		if (best_error < 0.0f || error < best_error) {
+			best_error = error;
+			e0 = q0;
+			e1 = q1;
+			std::copy(candidate, candidate + PIXEL_COUNT, indices);
+		}
+
+		float weights[PIXEL_COUNT];
+		for (int i = 0; i < PIXEL_COUNT; ++i)
+			weights[i] = BC7_WEIGHTS[candidate[i]] / 64.0f;
+		if (!refit_endpoints(pixels, weights, 4, start, end))
+			break;
+	}
+
+	// the anchor index is stored without its top bit, which therefore has to be 0
+	if (indices[0] & 8) {
+		std::swap(e0, e1);
+		for (int &index : indices)
+			index = 15 - index;
+	}
+
+	std::memset(block, 0, 16);
+	BitWriter writer{block, 0};
+	writer.write(1 << 6, 7);
+	for (int k = 0; k < 4; ++k) {
+		writer.write(static_cast<unsigned int>(e0.q[k]), 7);
+		writer.write(static_cast<unsigned int>(e1.q[k]), 7);
+	}
+	writer.write(static_cast<unsigned int>(e0.p), 1);
+	writer.write(static_cast<unsigned int>(e1.p), 1);
+	writer.write(static_cast<unsigned int>(indices[0]), 3);
+	for (int i = 1; i < PIXEL_COUNT; ++i)
+		writer.write(static_cast<unsigned int>(indices[i]), 4);
+}
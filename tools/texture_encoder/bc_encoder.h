@@ -0,0 +1,15 @@
+#pragma once
+
+// Encoders for a single 4x4 block of RGBA8 pixels in row order, 64 bytes.
+// Endpoints come from the principal axis of the block and get one least
+// squares refit against the chosen indices, good quality at a fraction of
+// the cost of an exhaustive search.
+
+// 8 bytes, RGB in four colour mode, alpha is ignored
+void encode_bc1(const unsigned char *rgba, unsigned char *block);
+// 16 bytes, BC4 alpha followed by a BC1 colour block
+void encode_bc3(const unsigned char *rgba, unsigned char *block);
+// 16 bytes, red and green as two BC4 blocks
+void encode_bc5(const unsigned char *rgba, unsigned char *block);
+// 16 bytes, mode 6 only: one RGBA subset, 7 bit endpoints with p-bits and 4 bit indices
+void encode_bc7(const unsigned char *rgba, unsigned char *block);
@@ -0,0 +1,116 @@
+//
+// Offline encoder that turns images into block compressed DDS files with
+// full mip chains, written next to each source. Texture, TextureRegistry
+// and AsyncTextureLoader pick them up in place of the source image, so
+// models keep referencing the original file names. asset_cooker does the
+// same for a whole asset directory as part of the build.
+//
+//	texture_encoder [--bc7] [--srgb] [--flip] [--force] <file or directory>...
+//
+// See texture_encoding.h for the formats chosen. --srgb filters colour mips
+// in linear space for images sampled as sRGB, --flip stores the rows bottom
+// up for assets of demos that call stbi_set_flip_vertically_on_load(true).
+// Files whose DDS is newer than the source are skipped unless --force.
+//
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "texture_encoding.h"
+#include "thread_pool.h"
+
+namespace fs = std::filesystem;
+
+struct EncoderStats {
+	unsigned int encoded = 0;
+	unsigned int skipped = 0;
+	unsigned int failed = 0;
+	size_t uncompressed_size = 0;
+	size_t compressed_size = 0;
+};
+
+static void encode_file(ThreadPool &pool, const fs::path &source, const TextureEncodingOptions &options, bool force, EncoderStats &stats)
+{
+	fs::path destination = source;
+	destination.replace_extension(".dds");
+
+	std::error_code error;
+	if (!force && fs::exists(destination, error)
+		&& fs::last_write_time(destination, error) >= fs::last_write_time(source, error) && !error) {
+		++stats.skipped;
+		return;
+	}
+
+	EncodedTexture encoded;
+	if (!encode_texture(pool, source, destination, options, encoded)) {
+		++stats.failed;
+		return;
+	}
+
+	++stats.encoded;
+	stats.uncompressed_size += encoded.uncompressed_size;
+	stats.compressed_size += encoded.compressed_size;
+	std::cout << destination.string() << ": " << encoded.width << "x" << encoded.height << " " << get_block_format_name(encoded.format)
+		<< (encoded.srgb ? " sRGB" : "") << ", " << encoded.level_count << " levels, "
+		<< encoded.uncompressed_size / 1024 << " KiB -> " << encoded.compressed_size / 1024 << " KiB" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+	TextureEncodingOptions options;
+	bool force = false;
+	std::vector<fs::path> inputs;
+	for (int i = 1; i < argc; ++i) {
+		const std::string argument = argv[i];
+		if (argument == "--bc7")
+			options.bc7 = true;
+		else if (argument == "--srgb")
+			options.srgb = true;
+		else if (argument == "--flip")
+			options.flip = true;
+		else if (argument == "--force")
+			force = true;
+		else if (argument.rfind("--", 0) == 0) {
+			std::cerr << "Unknown option " << argument << std::endl;
+			return 1;
+		}
+		else
+			inputs.emplace_back(argument);
+	}
+	if (inputs.empty()) {
+		std::cerr << "usage: texture_encoder [--bc7] [--srgb] [--flip] [--force] <file or directory>..." << std::endl;
+		return 1;
+	}
+
+	std::vector<fs::path> sources;
+	for (const fs::path &input : inputs) {
+		std::error_code error;
+		if (fs::is_directory(input, error)) {
+			for (const fs::directory_entry &entry : fs::recursive_directory_iterator(input, error)) {
+				if (entry.is_regular_file(error) && is_texture_source(entry.path()))
+					sources.push_back(entry.path());
+			}
+		}
+		else if (fs::is_regular_file(input, error))
+			sources.push_back(input);
+		else
+			std::cerr << "No such file or directory " << input.string() << std::endl;
+	}
+	std::sort(sources.begin(), sources.end());
+
+	ThreadPool pool;
+	EncoderStats stats;
+	for (const fs::path &source : sources)
+		encode_file(pool, source, options, force, stats);
+
+	std::cout << stats.encoded << " encoded, " << stats.skipped << " up to date, " << stats.failed << " failed";
+	if (stats.compressed_size > 0)
+		std::cout << ", " << stats.uncompressed_size / 1024 << " KiB -> " << stats.compressed_size / 1024 << " KiB ("
+			<< static_cast<double>(stats.uncompressed_size) / static_cast<double>(stats.compressed_size) << "x)";
+	std::cout << std::endl;
+	return stats.failed > 0 ? 1 : 0;
+}
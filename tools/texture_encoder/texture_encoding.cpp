@@ -0,0 +1,147 @@
+#include "texture_encoding.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include <stb_image.h>
+
+#include "bc_encoder.h"
+#include "mip_generator.h"
+#include "thread_pool.h"
+
+namespace fs = std::filesystem;
+
+static std::string to_lower(std::string text)
+{
+	std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	return text;
+}
+
+bool is_texture_source(const fs::path &path)
+{
+	const std::string extension = to_lower(path.extension().string());
+	return extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga" || extension == ".bmp";
+}
+
+bool is_normal_map(const fs::path &path)
+{
+	const std::string stem = to_lower(path.stem().string());
+	const auto ends_with = [&](const char *suffix) {
+		const size_t length = std::strlen(suffix);
+		return stem.size() >= length && stem.compare(stem.size() - length, length, suffix) == 0;
+	};
+	return stem.find("normal") != std::string::npos || ends_with("_n") || ends_with("_nrm") || ends_with("_norm");
+}
+
+// box filtered normals get shorter, stretch the xy of every mip back onto the unit sphere
+static void renormalize_normals(MipChain &chain)
+{
+	for (size_t i = 1; i < chain.levels.size(); ++i) {
+		const MipLevel &level = chain.levels[i];
+		unsigned char *pixel = chain.data.data() + level.offset;
+		for (int p = 0; p < level.width * level.height; ++p, pixel += 4) {
+			const float x = pixel[0] / 127.5f - 1.0f;
+			const float y = pixel[1] / 127.5f - 1.0f;
+			const float z = pixel[2] / 127.5f - 1.0f;
+			const float length = std::sqrt(x * x + y * y + z * z);
+			if (length < 1e-4f)
+				continue;
+			pixel[0] = static_cast<unsigned char>(std::lround((x / length + 1.0f) * 127.5f));
+			pixel[1] = static_cast<unsigned char>(std::lround((y / length + 1.0f) * 127.5f));
+			pixel[2] = static_cast<unsigned char>(std::lround((z / length + 1.0f) * 127.5f));
+		}
+	}
+}
+
+static void encode_level(ThreadPool &pool, const unsigned char *pixels, int width, int height, BlockFormat format, unsigned char *out)
+{
+	const int blocks_x = (width + 3) / 4;
+	const int blocks_y = (height + 3) / 4;
+	const size_t block_size = get_block_size(format);
+	pool.parallel_for(static_cast<size_t>(blocks_y), [&](size_t by) {
+		unsigned char block[64];
+		for (int bx = 0; bx < blocks_x; ++bx) {
+			// pixels past the edge of a partial block repeat the last row and column
+			for (int y = 0; y < 4; ++y) {
+				const int sy = std::min(static_cast<int>(by) * 4 + y, height - 1);
+				for (int x = 0; x < 4; ++x) {
+					const int sx = std::min(bx * 4 + x, width - 1);
+					std::memcpy(block + (y * 4 + x) * 4, pixels + (static_cast<size_t>(sy) * width + sx) * 4, 4);
+				}
+			}
+
+			unsigned char *destination = out + (by * blocks_x + bx) * block_size;
+			switch (format) {
+			case BlockFormat::BC1: encode_bc1(block, destination); break;
+			case BlockFormat::BC3: encode_bc3(block, destination); break;
+			case BlockFormat::BC5: encode_bc5(block, destination); break;
+			case BlockFormat::BC7: encode_bc7(block, destination); break;
+			}
+		}
+	});
+}
+
+const char* get_block_format_name(BlockFormat format)
+{
+	switch (format) {
+	case BlockFormat::BC1: return "BC1";
+	case BlockFormat::BC3: return "BC3";
+	case BlockFormat::BC5: return "BC5";
+	default: return "BC7";
+	}
+}
+
+bool encode_texture(ThreadPool &pool, const fs::path &source, const fs::path &destination,
+	const TextureEncodingOptions &options, EncodedTexture &encoded)
+{
+	// thread local, so several images can be encoded concurrently with different settings
+	stbi_set_flip_vertically_on_load_thread(options.flip);
+	int width = 0, height = 0, channels = 0;
+	unsigned char *pixels = decode_image_file(source.string(), width, height, channels, 4);
+	if (!pixels) {
+		const char *reason = stbi_failure_reason();
+		std::cerr << "Failed to load " << source.string() << ": " << (reason ? reason : "cannot be read") << std::endl;
+		return false;
+	}
+
+	const bool normal_map = is_normal_map(source);
+	bool has_alpha = false;
+	for (size_t i = 3; i < static_cast<size_t>(width) * height * 4 && !has_alpha; i += 4)
+		has_alpha = pixels[i] != 255;
+
+	CompressedImage image;
+	if (normal_map)
+		image.format = BlockFormat::BC5;
+	else if (options.bc7)
+		image.format = BlockFormat::BC7;
+	else
+		image.format = has_alpha ? BlockFormat::BC3 : BlockFormat::BC1;
+	image.srgb = options.srgb && !normal_map;
+
+	MipChain chain = generate_mip_chain(pixels, width, height, 4, image.srgb);
+	stbi_image_free(pixels);
+	if (normal_map)
+		renormalize_normals(chain);
+
+	size_t size = 0;
+	for (const MipLevel &level : chain.levels) {
+		image.levels.push_back({level.width, level.height, size});
+		size += get_compressed_level_size(image.format, level.width, level.height);
+	}
+	image.data.resize(size);
+	for (size_t i = 0; i < chain.levels.size(); ++i) {
+		const MipLevel &level = chain.levels[i];
+		encode_level(pool, chain.data.data() + level.offset, level.width, level.height, image.format,
+			image.data.data() + image.levels[i].offset);
+	}
+
+	if (!write_dds(destination.string(), image))
+		return false;
+
+	encoded = {width, height, image.format, image.srgb, image.levels.size(), chain.data.size(), image.data.size()};
+	return true;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+
+#include "texture_container.h"
+
+class ThreadPool;
+
+// Image to DDS conversion shared by texture_encoder and asset_cooker.
+// Normal maps (names containing "normal", or ending in _n, _nrm or _norm)
+// become BC5 with renormalized mips. Other images become BC1, or BC3 when
+// they have alpha, or BC7 when asked for.
+
+struct TextureEncodingOptions {
+	// BC7 instead of BC1 and BC3 for colour images
+	bool bc7 = false;
+	// filter colour mips in linear space, for images sampled as sRGB
+	bool srgb = false;
+	// store the rows bottom up like stbi_set_flip_vertically_on_load(true),
+	// for images of demos that set it
+	bool flip = false;
+};
+
+struct EncodedTexture {
+	int width;
+	int height;
+	BlockFormat format;
+	bool srgb;
+	size_t level_count;
+	// RGBA8 with mips, what the image takes uncompressed in VRAM
+	size_t uncompressed_size;
+	size_t compressed_size;
+};
+
+// png, jpg, tga or bmp
+bool is_texture_source(const std::filesystem::path &path);
+bool is_normal_map(const std::filesystem::path &path);
+const char* get_block_format_name(BlockFormat format);
+
+// Encodes the image at source into a DDS at destination, the blocks of
+// each level are spread over pool. Prints why and returns false when the
+// image cannot be read or the DDS cannot be written.
+bool encode_texture(ThreadPool &pool, const std::filesystem::path &source, const std::filesystem::path &destination,
+	const TextureEncodingOptions &options, EncodedTexture &encoded);